@@ -19,9 +19,6 @@
 #ifndef itkDescoteauxEigenToMeasureImageFilter_hxx
 #define itkDescoteauxEigenToMeasureImageFilter_hxx
 
-#include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkImageRegionIterator.h"
-
 namespace itk
 {
 template <typename TInputImage, typename TOutputImage>
@@ -33,56 +30,38 @@ template <typename TInputImage, typename TOutputImage>
 void
 DescoteauxEigenToMeasureImageFilter<TInputImage, TOutputImage>::BeforeThreadedGenerateData()
 {
-  ParameterArrayType parameters = this->GetParametersInput()->Get();
+  const ParameterArrayType parameters = this->GetParametersInput()->Get();
   if (parameters.GetSize() != 3)
   {
     itkExceptionMacro(<< "Parameters must have size 3. Given array of size " << parameters.GetSize());
   }
+
+  /* Snapshot of the parameters for the whole update */
+  m_Functor = FunctorType(parameters[0], parameters[1], parameters[2], m_EnhanceType);
+  m_FastFunctor = FastFunctorType(parameters[0], parameters[1], parameters[2], m_EnhanceType);
 }
 
 template <typename TInputImage, typename TOutputImage>
-typename DescoteauxEigenToMeasureImageFilter<TInputImage, TOutputImage>::OutputImagePixelType
-DescoteauxEigenToMeasureImageFilter<TInputImage, TOutputImage>::ProcessPixel(const InputImagePixelType & pixel)
+void
+DescoteauxEigenToMeasureImageFilter<TInputImage, TOutputImage>::GenerateData()
 {
-  /* Grab parameters */
-  ParameterArrayType parameters = this->GetParametersInput()->Get();
-  RealType           alpha = parameters[0];
-  RealType           beta = parameters[1];
-  RealType           c = parameters[2];
-
-  /* Grab pixel values */
-  double sheetness = 0.0;
-  auto   a1 = static_cast<double>(pixel[0]);
-  auto   a2 = static_cast<double>(pixel[1]);
-  auto   a3 = static_cast<double>(pixel[2]);
-  double l1 = itk::Math::abs(a1);
-  double l2 = itk::Math::abs(a2);
-  double l3 = itk::Math::abs(a3);
-
-  /* Deal with l3 > 0 */
-  if (m_EnhanceType * a3 < 0)
+  if (this->GetApproximationLevel() == Superclass::ApproximationLevelEnum::Fast)
   {
-    return static_cast<OutputImagePixelType>(0.0);
+    this->GenerateDataUsingFunctor(m_FastFunctor);
   }
-
-  /* Avoid divisions by zero (or close to zero) */
-  if (l3 < Math::eps)
+  else
   {
-    return static_cast<OutputImagePixelType>(0.0);
+    this->GenerateDataUsingFunctor(m_Functor);
   }
+}
 
-  /* Compute measures */
-  const double Rsheet = l2 / l3;
-  const double Rblob = itk::Math::abs(2 * l3 - l2 - l1) / l3;
-  const double Rnoise = sqrt(l1 * l1 + l2 * l2 + l3 * l3);
-
-  /* Multiply together to get sheetness */
-  sheetness = 1.0;
-  sheetness *= std::exp(-(Rsheet * Rsheet) / (2 * alpha * alpha));
-  sheetness *= (1.0 - std::exp(-(Rblob * Rblob) / (2 * beta * beta)));
-  sheetness *= (1.0 - std::exp(-(Rnoise * Rnoise) / (2 * c * c)));
-
-  return static_cast<OutputImagePixelType>(sheetness);
+template <typename TInputImage, typename TOutputImage>
+typename DescoteauxEigenToMeasureImageFilter<TInputImage, TOutputImage>::OutputImagePixelType
+DescoteauxEigenToMeasureImageFilter<TInputImage, TOutputImage>::ProcessPixel(const InputImagePixelType & pixel)
+{
+  /* Grab parameters */
+  const ParameterArrayType parameters = this->GetParametersInput()->Get();
+  return FunctorType(parameters[0], parameters[1], parameters[2], m_EnhanceType)(pixel);
 }
 
 template <typename TInputImage, typename TOutputImage>
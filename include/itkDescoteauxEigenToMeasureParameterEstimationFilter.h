@@ -21,7 +21,6 @@
 
 #include "itkMath.h"
 #include "itkEigenToMeasureParameterEstimationFilter.h"
-#include <mutex>
 
 namespace itk
 {
@@ -42,6 +41,9 @@ namespace itk
  * If a mask is given, parameters are evaluated only where IsInside returns
  * true.
  *
+ * A sample only bounds the maximum from below, so TargetRelativeError is
+ * ignored and every pixel is visited. The half widths of the parameters are 0.
+ *
  * \sa DescoteauxEigenToMeasureImageFilter
  * \sa EigenToMeasureParameterEstimationFilter
  * \sa MultiScaleHessianEnhancementImageFilter
@@ -67,6 +69,7 @@ public:
   using InputImagePointer = typename Superclass::InputImagePointer;
   using InputImageConstPointer = typename Superclass::InputImageConstPointer;
   using InputImageRegionType = typename Superclass::InputImageRegionType;
+  using InputImageIndexType = typename Superclass::InputImageIndexType;
   using InputImagePixelType = typename Superclass::InputImagePixelType;
   using PixelValueType = typename Superclass::PixelValueType;
 
@@ -78,12 +81,17 @@ public:
   /** Input Mask typedefs. */
   using MaskSpatialObjectType = typename Superclass::MaskSpatialObjectType;
   using MaskSpatialObjectTypeConstPointer = typename Superclass::MaskSpatialObjectTypeConstPointer;
+  using VoxelMaskType = typename Superclass::VoxelMaskType;
 
   /** Parameter typedefs */
   using RealType = typename Superclass::RealType;
   using ParameterArrayType = typename Superclass::ParameterArrayType;
   using ParameterDecoratedType = typename Superclass::ParameterDecoratedType;
 
+  /** Hessian typedefs */
+  using HessianPixelType = typename Superclass::HessianPixelType;
+  using HessianImageType = typename Superclass::HessianImageType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
@@ -94,6 +102,13 @@ public:
   itkSetMacro(FrobeniusNormWeight, RealType);
   itkGetConstMacro(FrobeniusNormWeight, RealType);
 
+  /** The Frobenius norm of the eigenvalues is that of the hessian. */
+  bool
+  CanEstimateFromHessianInvariants() const override
+  {
+    return true;
+  }
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro(InputHaveDimension3Check, (Concept::SameDimension<TInputImage::ImageDimension, 3u>));
@@ -116,6 +131,10 @@ protected:
   void
   DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
+  /** Take the maximum Frobenius norm of the hessian. */
+  void
+  AccumulateHessianInvariants(const HessianImageType * hessian, const InputImageRegionType & region) override;
+
   inline RealType
   CalculateFrobeniusNorm(const InputImagePixelType & pixel) const;
 
@@ -123,11 +142,15 @@ protected:
   PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
+  /** Take the maximum of normOfPixel(pixel) over the pixels of a piece of the
+   * image, the input or the hessian. */
+  template <typename TImage, typename TNorm>
+  void
+  AccumulateMaximumNorm(const TImage * image, const InputImageRegionType & region, TNorm normOfPixel);
+
   /* Member variables */
   RealType m_FrobeniusNormWeight;
   RealType m_MaxFrobeniusNorm;
-
-  std::mutex m_Mutex;
 }; // end class
 } // namespace itk
 
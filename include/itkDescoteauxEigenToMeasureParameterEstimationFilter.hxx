@@ -19,6 +19,9 @@
 #ifndef itkDescoteauxEigenToMeasureParameterEstimationFilter_hxx
 #define itkDescoteauxEigenToMeasureParameterEstimationFilter_hxx
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace itk
 {
@@ -68,6 +71,11 @@ DescoteauxEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::Af
   parameters[1] = beta;
   parameters[2] = c;
   this->GetParametersOutput()->Set(parameters);
+
+  /* The maximum is computed from every pixel */
+  ParameterArrayType halfWidths(3);
+  halfWidths.Fill(NumericTraits<RealType>::ZeroValue());
+  this->GetParametersHalfWidthOutput()->Set(halfWidths);
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -82,58 +90,65 @@ DescoteauxEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::Dy
     return;
   }
 
-  /* Get input and mask pointer */
-  InputImageConstPointer            inputPointer = this->GetInput();
-  MaskSpatialObjectTypeConstPointer maskPointer = this->GetMask();
-
-  OutputImageType * outputPtr = this->GetOutput(0);
-
-  // Define the portion of the input to walk for this thread, using
-  // the CallCopyOutputRegionToInputRegion method allows for the input
-  // and output images to be different dimensions
-  InputImageRegionType inputRegionForThread;
-
-  this->CallCopyOutputRegionToInputRegion(inputRegionForThread, outputRegionForThread);
-
-  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
-
-  mt->ParallelizeImageRegion<TInputImage::ImageDimension>(
-    outputRegionForThread,
-    [inputPointer, maskPointer, outputPtr, this](const OutputImageRegionType region) {
-      /* Keep track of the current max */
-      RealType max = NumericTraits<RealType>::NonpositiveMin();
-
-      typename InputImageType::PointType point;
+  this->AccumulateMaximumNorm(
+    this->GetInput(), outputRegionForThread, [this](const InputImagePixelType & pixel) -> RealType {
+      return this->CalculateFrobeniusNorm(pixel);
+    });
+}
 
-      /* Setup iterator */
-      ImageRegionConstIteratorWithIndex<TInputImage> inputIt(inputPointer, region);
-      ImageRegionIterator<OutputImageType>           outputIt(outputPtr, region);
+template <typename TInputImage, typename TOutputImage>
+void
+DescoteauxEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AccumulateHessianInvariants(
+  const HessianImageType *     hessian,
+  const InputImageRegionType & region)
+{
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
 
-      /* Iterate and count */
-      while (!inputIt.IsAtEnd())
+  /* The off-diagonal elements are stored once but count twice */
+  this->AccumulateMaximumNorm(hessian, region, [](const HessianPixelType & tensor) -> RealType {
+    RealType norm = 0;
+    for (unsigned int i = 0; i < HessianPixelType::Dimension; ++i)
+    {
+      for (unsigned int j = 0; j < HessianPixelType::Dimension; ++j)
       {
-        // Process point
-        inputPointer->TransformIndexToPhysicalPoint(inputIt.GetIndex(), point);
-        if ((!maskPointer) || (maskPointer->IsInsideInObjectSpace(point)))
-        {
-          /* Compute max norm */
-          max = std::max(max, this->CalculateFrobeniusNorm(inputIt.Get()));
-        }
-
-        // Set
-        outputIt.Set(static_cast<OutputImagePixelType>(inputIt.Get()));
-
-        // Increment
-        ++inputIt;
-        ++outputIt;
+        norm += tensor(i, j) * tensor(i, j);
       }
+    }
+    return std::sqrt(norm);
+  });
+}
 
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage, typename TNorm>
+void
+DescoteauxEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AccumulateMaximumNorm(
+  const TImage *               image,
+  const InputImageRegionType & region,
+  TNorm                        normOfPixel)
+{
+  using PixelType = typename TImage::PixelType;
+
+  /* Take the maximum norm of every block on a single work unit */
+  std::vector<RealType> blocks(this->ComputeNumberOfBlocks(region), NumericTraits<RealType>::NonpositiveMin());
+  this->ParallelizeBlocks(region, [&](SizeValueType block, const InputImageRegionType & blockRegion) {
+    RealType max = NumericTraits<RealType>::NonpositiveMin();
+    this->VisitPixelsInsideMask(image, blockRegion, [&](const PixelType * pixels, SizeValueType n) {
+      for (SizeValueType i = 0; i < n; ++i)
+      {
+        max = std::max(max, normOfPixel(pixels[i]));
+      }
+    });
+    blocks[block] = max;
+  });
 
-      /* Block and store */
-      std::lock_guard<std::mutex> mutexHolder(m_Mutex);
-      m_MaxFrobeniusNorm = std::max(m_MaxFrobeniusNorm, max);
-    },
-    nullptr);
+  /* Merge in block order */
+  for (const RealType max : blocks)
+  {
+    m_MaxFrobeniusNorm = std::max(m_MaxFrobeniusNorm, max);
+  }
 }
 
 template <typename TInputImage, typename TOutputImage>
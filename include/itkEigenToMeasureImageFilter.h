@@ -21,7 +21,10 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkSimpleDataObjectDecorator.h"
+#include "itkMaximumAbsoluteValueImageFilter.h"
 #include "itkSpatialObject.h"
+#include "itkVoxelMask.h"
+#include <type_traits>
 
 namespace itk
 {
@@ -32,6 +35,29 @@ namespace itk
  * Any algorithm implementing a local-structure measure should inherit from this class
  * so they can be used in the MultiScaleHessianEnhancementImageFilter framework.
  *
+ * Subclasses either implement ProcessPixel(), which is called once per pixel
+ * through a virtual call, or override GenerateData() to call
+ * GenerateDataUsingFunctor() with a functor holding a snapshot of the
+ * parameters. The functor is typically built in BeforeThreadedGenerateData(),
+ * which GenerateDataUsingFunctor() calls before reading it, and is inlined in
+ * the loop over the scanlines. A functor can also provide
+ * Evaluate(const InputImagePixelType *, OutputImagePixelType *, SizeValueType)
+ * to compute contiguous pixels at once, which is used for the scanlines not
+ * restricted by a mask and for the runs of pixels inside a VoxelMask.
+ *
+ * An Accumulator image can be set to take the maximum over several measures,
+ * as MultiScaleHessianEnhancementImageFilter does over the scales. The output
+ * then shares the buffer of the accumulator and every pixel of the requested
+ * region is set to the value of largest absolute value between the measure and
+ * the accumulator, as MaximumAbsoluteValueImageFilter would, without
+ * allocating an output. The pixels outside of the mask are left unchanged.
+ *
+ * The ApproximationLevel lets subclasses trade accuracy for speed. At the
+ * Exact level the measure is computed in double precision. At the Fast level
+ * subclasses supporting it compute the measure in single precision with
+ * polynomial exponentials, within the absolute error they document, which is
+ * enough when the measure is thresholded.
+ *
  * \sa MultiScaleHessianEnhancementImageFilter
  * \sa EigenToMeasureParameterEstimationFilter
  *
@@ -58,6 +84,7 @@ public:
   using InputImagePointer = typename InputImageType::Pointer;
   using InputImageConstPointer = typename InputImageType::ConstPointer;
   using InputImageRegionType = typename InputImageType::RegionType;
+  using InputImageIndexType = typename InputImageType::IndexType;
   using InputImagePixelType = typename InputImageType::PixelType;
   using PixelValueType = typename InputImagePixelType::ValueType;
   itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
@@ -85,6 +112,13 @@ public:
   itkSetInputMacro(Mask, MaskSpatialObjectType);
   itkGetInputMacro(Mask, MaskSpatialObjectType);
 
+  /** Set/Get the mask rasterized on the grid of the input. When it applies to
+   * the input it is used in place of Mask and only its runs of pixels are
+   * processed. Otherwise Mask is used. \sa VoxelMask::IsOnGridOf */
+  using VoxelMaskType = VoxelMask<Self::ImageDimension>;
+  itkSetConstObjectMacro(VoxelMask, VoxelMaskType);
+  itkGetConstObjectMacro(VoxelMask, VoxelMaskType);
+
   /**\class EigenValueOrderEnum
    * Template the EigenValueOrderEnum. Methods that inherit from this class can override this function
    * to produce a different eigenvalue ordering. Ideally, the enum EigenValueOrderEnum should come from
@@ -109,6 +143,27 @@ public:
   virtual EigenValueOrderEnum
   GetEigenValueOrder() const = 0;
 
+  /**\class ApproximationLevelEnum
+   * Accuracy of the computation of the measure.
+   * \ingroup BoneEnhancement
+   */
+  enum class ApproximationLevelEnum : uint8_t
+  {
+    Exact = 1,
+    Fast
+  };
+
+  /** Set/Get the image the measure is accumulated into, or nullptr to
+   * allocate the output. It must buffer the requested region of the output and
+   * is updated in place. */
+  itkSetObjectMacro(Accumulator, OutputImageType);
+  itkGetModifiableObjectMacro(Accumulator, OutputImageType);
+
+  /** Set/Get the accuracy of the measure. Defaults to Exact. Subclasses
+   * without a faster approximation compute the measure exactly at every level. */
+  itkSetEnumMacro(ApproximationLevel, ApproximationLevelEnum);
+  itkGetEnumMacro(ApproximationLevel, ApproximationLevelEnum);
+
 protected:
   EigenToMeasureImageFilter() = default;
   ~EigenToMeasureImageFilter() override = default;
@@ -116,8 +171,72 @@ protected:
   virtual OutputImagePixelType
   ProcessPixel(const InputImagePixelType & pixel) = 0;
 
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Compute the output with ProcessPixel(). */
   void
   GenerateData() override;
+
+  /** Compute the output by applying the functor to every pixel inside the
+   * voxel mask or the mask, the pixels outside being set to zero. The functor must be callable
+   * on an input pixel from several threads and is read after
+   * BeforeThreadedGenerateData() was called. */
+  template <typename TFunctor>
+  void
+  GenerateDataUsingFunctor(const TFunctor & functor);
+
+  /** Whether a functor evaluates contiguous pixels with Evaluate() */
+  template <typename TFunctor, typename = void>
+  struct HasBatchEvaluation : std::false_type
+  {};
+  template <typename TFunctor>
+  struct HasBatchEvaluation<TFunctor,
+                            decltype(std::declval<const TFunctor &>().Evaluate(
+                                       std::declval<const InputImagePixelType *>(),
+                                       std::declval<OutputImagePixelType *>(),
+                                       SizeValueType()),
+                                     void())> : std::true_type
+  {};
+
+  /** Apply a functor to n contiguous pixels */
+  template <typename TFunctor>
+  static void
+  ApplyToPixels(const TFunctor &            functor,
+                const InputImagePixelType * input,
+                OutputImagePixelType *      output,
+                SizeValueType               n,
+                std::true_type)
+  {
+    functor.Evaluate(input, output, n);
+  }
+  template <typename TFunctor>
+  static void
+  ApplyToPixels(const TFunctor &            functor,
+                const InputImagePixelType * input,
+                OutputImagePixelType *      output,
+                SizeValueType               n,
+                std::false_type)
+  {
+    for (SizeValueType i = 0; i < n; ++i)
+    {
+      output[i] = functor(input[i]);
+    }
+  }
+
+  /** Keep the value of largest absolute value of n contiguous measures and
+   * accumulated values in the latter, the measure on ties, see
+   * Functor::MaximumAbsoluteValueSpan() */
+  static void
+  AccumulateMaximumAbsoluteValue(const OutputImagePixelType * measure, OutputImagePixelType * output, SizeValueType n)
+  {
+    Functor::MaximumAbsoluteValueSpan(output, measure, output, n);
+  }
+
+private:
+  ApproximationLevelEnum               m_ApproximationLevel{ ApproximationLevelEnum::Exact };
+  OutputImagePointer                   m_Accumulator;
+  typename VoxelMaskType::ConstPointer m_VoxelMask;
 }; // end class
 } // namespace itk
 
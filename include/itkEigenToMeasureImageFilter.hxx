@@ -19,8 +19,9 @@
 #ifndef itkEigenToMeasureImageFilter_hxx
 #define itkEigenToMeasureImageFilter_hxx
 
-#include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkImageRegionIterator.h"
+#include "itkImageScanlineIterator.h"
+#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -28,48 +29,124 @@ namespace itk
 template <typename TInputImage, typename TOutputImage>
 void
 EigenToMeasureImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  this->GenerateDataUsingFunctor([this](const InputImagePixelType & pixel) { return this->ProcessPixel(pixel); });
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TFunctor>
+void
+EigenToMeasureImageFilter<TInputImage, TOutputImage>::GenerateDataUsingFunctor(const TFunctor & functor)
 {
   const InputImageType *        inputPtr = this->GetInput(0);
   OutputImageType *             outputPtr = this->GetOutput(0);
   const MaskSpatialObjectType * maskPointer = this->GetMask();
-
-  this->AllocateOutputs();
+  const VoxelMaskType *         voxelMask =
+    m_VoxelMask && m_VoxelMask->IsOnGridOf(inputPtr) ? m_VoxelMask.GetPointer() : nullptr;
+
+  /* The output is written over the accumulator rather than allocated */
+  const bool accumulate = m_Accumulator.IsNotNull();
+  if (accumulate)
+  {
+    const OutputImageRegionType requestedRegion = outputPtr->GetRequestedRegion();
+    if (requestedRegion.GetNumberOfPixels() > 0 && !m_Accumulator->GetBufferedRegion().IsInside(requestedRegion))
+    {
+      itkExceptionMacro(<< "The accumulator buffers " << m_Accumulator->GetBufferedRegion()
+                        << " which does not hold the requested region " << requestedRegion);
+    }
+    outputPtr->Graft(m_Accumulator);
+    outputPtr->SetRequestedRegion(requestedRegion);
+  }
+  else
+  {
+    this->AllocateOutputs();
+  }
 
   this->BeforeThreadedGenerateData();
 
-  const OutputImageRegionType requestedRegion(outputPtr->GetRequestedRegion());
-
-  // Define the portion of the input to walk for this thread, using
-  // the CallCopyOutputRegionToInputRegion method allows for the input
-  // and output images to be different dimensions
-  InputImageRegionType inputRegionForThread;
-  this->CallCopyOutputRegionToInputRegion(inputRegionForThread, requestedRegion);
-
   MultiThreaderBase::Pointer mt = this->GetMultiThreader();
 
   mt->ParallelizeImageRegion<TInputImage::ImageDimension>(
-    requestedRegion,
-    [inputPtr, maskPointer, outputPtr, this](const OutputImageRegionType & region) {
+    outputPtr->GetRequestedRegion(),
+    [inputPtr, maskPointer, voxelMask, outputPtr, accumulate, &functor](const OutputImageRegionType & region) {
       typename InputImageType::PointType point;
 
       /* Setup iterator */
-      ImageRegionConstIteratorWithIndex<TInputImage> inputIt(inputPtr, region);
-      ImageRegionIterator<OutputImageType>           outputIt(outputPtr, region);
+      ImageScanlineConstIterator<TInputImage> inputIt(inputPtr, region);
+      ImageScanlineIterator<OutputImageType>  outputIt(outputPtr, region);
+
+      /* Contiguous measures are computed in a line buffer before being accumulated */
+      const SizeValueType               lineLength = region.GetSize(0);
+      std::vector<OutputImagePixelType> measures(accumulate ? lineLength : 0);
+      auto applyToPixels = [&functor, &measures, accumulate](
+                             const InputImagePixelType * input, OutputImagePixelType * output, SizeValueType n) {
+        if (accumulate)
+        {
+          Self::ApplyToPixels(functor, input, measures.data(), n, HasBatchEvaluation<TFunctor>());
+          Self::AccumulateMaximumAbsoluteValue(measures.data(), output, n);
+        }
+        else
+        {
+          Self::ApplyToPixels(functor, input, output, n, HasBatchEvaluation<TFunctor>());
+        }
+      };
 
       while (!inputIt.IsAtEnd())
       {
-        inputPtr->TransformIndexToPhysicalPoint(inputIt.GetIndex(), point);
-        if ((!maskPointer) || (maskPointer->IsInsideInObjectSpace(point)))
+        /* The pixels of a scanline are contiguous in both images */
+        const InputImageIndexType   lineIndex = inputIt.GetIndex();
+        const InputImagePixelType * input = inputPtr->GetBufferPointer() + inputPtr->ComputeOffset(lineIndex);
+        OutputImagePixelType *      output = outputPtr->GetBufferPointer() + outputPtr->ComputeOffset(lineIndex);
+
+        if (voxelMask)
+        {
+          /* Apply the functor to the runs inside the mask and zero the gaps, unless accumulating */
+          SizeValueType done = 0;
+          voxelMask->VisitRuns(lineIndex, lineLength, [&](IndexValueType start, SizeValueType length) {
+            const SizeValueType offset = static_cast<SizeValueType>(start - lineIndex[0]);
+            if (!accumulate)
+            {
+              std::fill(output + done, output + offset, NumericTraits<OutputImagePixelType>::Zero);
+            }
+            applyToPixels(input + offset, output + offset, length);
+            done = offset + length;
+          });
+          if (!accumulate)
+          {
+            std::fill(output + done, output + lineLength, NumericTraits<OutputImagePixelType>::Zero);
+          }
+        }
+        else if (!maskPointer)
         {
-          outputIt.Set(this->ProcessPixel(inputIt.Get()));
+          applyToPixels(input, output, lineLength);
         }
         else
         {
-          outputIt.Set(NumericTraits<OutputImagePixelType>::Zero);
+          while (!inputIt.IsAtEndOfLine())
+          {
+            inputPtr->TransformIndexToPhysicalPoint(inputIt.GetIndex(), point);
+            if (maskPointer->IsInsideInObjectSpace(point))
+            {
+              const OutputImagePixelType measure = functor(inputIt.Get());
+              OutputImagePixelType       value = measure;
+              if (accumulate)
+              {
+                value = outputIt.Get();
+                Self::AccumulateMaximumAbsoluteValue(&measure, &value, 1);
+              }
+              outputIt.Set(value);
+            }
+            else if (!accumulate)
+            {
+              outputIt.Set(NumericTraits<OutputImagePixelType>::Zero);
+            }
+            ++inputIt;
+            ++outputIt;
+          }
         }
 
-        ++inputIt;
-        ++outputIt;
+        inputIt.NextLine();
+        outputIt.NextLine();
       }
     },
     nullptr);
@@ -77,6 +154,16 @@ EigenToMeasureImageFilter<TInputImage, TOutputImage>::GenerateData()
   this->AfterThreadedGenerateData();
 }
 
+template <typename TInputImage, typename TOutputImage>
+void
+EigenToMeasureImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "ApproximationLevel: " << static_cast<int>(m_ApproximationLevel) << std::endl;
+  os << indent << "VoxelMask: " << m_VoxelMask.GetPointer() << std::endl;
+  os << indent << "Accumulator: " << m_Accumulator.GetPointer() << std::endl;
+}
+
 } // namespace itk
 
 #endif /* itkEigenToMeasureImageFilter_hxx */
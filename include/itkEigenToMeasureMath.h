@@ -0,0 +1,266 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkEigenToMeasureMath_h
+#define itkEigenToMeasureMath_h
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace itk
+{
+/** \namespace EigenToMeasureMath
+ * \brief Elementary functions written so loops calling them are vectorized.
+ *
+ * The functions are branch free and inline, so a loop over an array calling
+ * them is vectorized by the compiler, unlike a loop calling std::exp. They
+ * are used by the batched eigenvalue solvers and by the batch evaluation of
+ * the measure functors.
+ *
+ * \ingroup BoneEnhancement
+ */
+namespace EigenToMeasureMath
+{
+/** All bits set if the sign bit of x is set, none otherwise. Used in place
+ * of a comparison, x < y being NegativeMask(x - y) up to the sign of zero and
+ * NaN: comparisons of floating point values and the conditional operator are
+ * kept as branches by compilers unless they may reorder floating point
+ * exceptions, whereas these bit operations are vectorized with any
+ * instruction set and the default floating point model. */
+inline std::uint64_t
+NegativeMask(double x)
+{
+  std::uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return std::uint64_t{ 0 } - (bits >> 63);
+}
+
+inline std::uint32_t
+NegativeMask(float x)
+{
+  std::uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return std::uint32_t{ 0 } - (bits >> 31);
+}
+
+/** Bits of ifTrue where mask is set and of ifFalse elsewhere. */
+inline double
+Select(std::uint64_t mask, double ifTrue, double ifFalse)
+{
+  std::uint64_t trueBits;
+  std::uint64_t falseBits;
+  std::memcpy(&trueBits, &ifTrue, sizeof(trueBits));
+  std::memcpy(&falseBits, &ifFalse, sizeof(falseBits));
+  const std::uint64_t bits = (trueBits & mask) | (falseBits & ~mask);
+  double              selected;
+  std::memcpy(&selected, &bits, sizeof(selected));
+  return selected;
+}
+
+inline float
+Select(std::uint32_t mask, float ifTrue, float ifFalse)
+{
+  std::uint32_t trueBits;
+  std::uint32_t falseBits;
+  std::memcpy(&trueBits, &ifTrue, sizeof(trueBits));
+  std::memcpy(&falseBits, &ifFalse, sizeof(falseBits));
+  const std::uint32_t bits = (trueBits & mask) | (falseBits & ~mask);
+  float               selected;
+  std::memcpy(&selected, &bits, sizeof(selected));
+  return selected;
+}
+
+/** Arc cosine in double precision for arguments in [-1, 1], within 3 ULP of
+ * std::acos.
+ *
+ * With a = |x|, acos(a) is pi / 2 - asin(a) up to a = 1 / 2 and
+ * 2 asin(sqrt((1 - a) / 2)) above, so asin(t) is only evaluated for t in
+ * [0, 1 / 2], as t + t s P(s) with s = t^2. P is the polynomial of degree 12
+ * interpolating (asin(t) - t) / (t s) at Chebyshev nodes of [0, 1 / 4], with
+ * a relative error below 2e-16. Negative arguments use acos(x) = pi - acos(-x),
+ * with a two part pi. The square root is computed for every argument, loops
+ * calling std::sqrt are only vectorized when the compiler may ignore errno,
+ * as with -fno-math-errno. */
+inline double
+Acos(double x)
+{
+  constexpr double halfPiHigh = 1.5707963267948966;
+  constexpr double halfPiLow = 6.123233995736766e-17;
+  constexpr double piHigh = 3.141592653589793;
+  constexpr double piLow = 1.2246467991473532e-16;
+
+  const double        a = std::abs(x);
+  const std::uint64_t large = NegativeMask(0.5 - a);
+  const double        s = Select(large, 0.5 - 0.5 * a, a * a);
+  const double        t = Select(large, std::sqrt(s), a);
+
+  double p = 0.028757851367421566;
+  p = p * s - 0.014851887071247207;
+  p = p * s + 0.017400879442694025;
+  p = p * s + 0.005457506718640357;
+  p = p * s + 0.01032281435018578;
+  p = p * s + 0.011479177415184906;
+  p = p * s + 0.013971212973552933;
+  p = p * s + 0.017352392720869973;
+  p = p * s + 0.02237217294214989;
+  p = p * s + 0.030381944138531247;
+  p = p * s + 0.04464285714635543;
+  p = p * s + 0.07499999999998433;
+  p = p * s + 0.16666666666666669;
+  const double asinT = t + t * s * p;
+
+  const double acosA = Select(large, 2.0 * asinT, (halfPiHigh - asinT) + halfPiLow);
+  return Select(NegativeMask(x), (piHigh - acosA) + piLow, acosA);
+}
+
+/** Cosine in double precision for arguments in [-pi, pi], within 5e-16 of
+ * std::cos.
+ *
+ * With a = |x|, cos(a) is -cos(pi - a) above pi / 2, pi - a being computed
+ * exactly with a two part pi, so the cosine is only evaluated on [0, pi / 2],
+ * by the polynomial of degree 9 in a^2 interpolating it at Chebyshev nodes,
+ * with an error below 2e-17. */
+inline double
+Cos(double x)
+{
+  constexpr double halfPi = 1.5707963267948966;
+  constexpr double piHigh = 3.141592653589793;
+  constexpr double piLow = 1.2246467991473532e-16;
+
+  const double        a = std::abs(x);
+  const std::uint64_t large = NegativeMask(halfPi - a);
+  const double        b = Select(large, (piHigh - a) + piLow, a);
+  const double        u = b * b;
+
+  double p = -1.5119827834217995e-16;
+  p = p * u + 4.7768722491448073e-14;
+  p = p * u - 1.1470670165323271e-11;
+  p = p * u + 2.0876755666578904e-09;
+  p = p * u - 2.755731920965447e-07;
+  p = p * u + 2.480158730149264e-05;
+  p = p * u - 0.001388888888888853;
+  p = p * u + 0.04166666666666666;
+  p = p * u - 0.5;
+  p = p * u + 1.0;
+
+  return Select(large, -p, p);
+}
+
+/** Exponential in double precision, within 2 ULP of std::exp for arguments
+ * in [-708.39, 709]. Smaller arguments return zero instead of a subnormal
+ * number and larger ones return exp(709).
+ *
+ * The argument is reduced to x = k ln(2) + r with |r| <= ln(2) / 2 using a
+ * two part ln(2), e^r is evaluated by its Taylor polynomial of degree 13
+ * whose truncation error is below 0.03 ULP, and 2^k is built in the exponent
+ * bits. */
+inline double
+Exp(double x)
+{
+  constexpr double log2e = 1.4426950408889634074;
+  constexpr double ln2High = 6.93147180369123816490e-01;
+  constexpr double ln2Low = 1.90821492927058770002e-10;
+  constexpr double shifter = 6755399441055744.0; // 1.5 * 2^52
+  constexpr double minimum = -708.39641853226408;
+  constexpr double maximum = 709.0;
+
+  const std::uint64_t underflow = NegativeMask(x - minimum);
+  double              clamped = Select(underflow, minimum, x);
+  clamped = Select(NegativeMask(maximum - clamped), maximum, clamped);
+
+  /* Adding the shifter rounds x / ln(2) to the nearest integer k, stored in
+   * the low bits of the mantissa */
+  const double shifted = clamped * log2e + shifter;
+  const double k = shifted - shifter;
+  const double r = (clamped - k * ln2High) - k * ln2Low;
+
+  double p = 1.0 / 6227020800.0;
+  p = p * r + 1.0 / 479001600.0;
+  p = p * r + 1.0 / 39916800.0;
+  p = p * r + 1.0 / 3628800.0;
+  p = p * r + 1.0 / 362880.0;
+  p = p * r + 1.0 / 40320.0;
+  p = p * r + 1.0 / 5040.0;
+  p = p * r + 1.0 / 720.0;
+  p = p * r + 1.0 / 120.0;
+  p = p * r + 1.0 / 24.0;
+  p = p * r + 1.0 / 6.0;
+  p = p * r + 0.5;
+  p = p * r + 1.0;
+  p = p * r + 1.0;
+
+  /* The low 12 bits of the shifted value hold k + 1023 modulo 4096 once the bias is added */
+  std::uint64_t bits;
+  std::memcpy(&bits, &shifted, sizeof(bits));
+  bits = (bits + 1023) << 52;
+  double scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+
+  return Select(underflow, 0.0, p * scale);
+}
+
+/** Exponential in single precision, within 2 ULP of the correctly rounded
+ * value for arguments in [-27, 88], that is a relative error below 2.4e-7.
+ * Smaller arguments return zero and larger ones return exp(88).
+ *
+ * Results below exp(-27), about 1.9e-12, are flushed to zero so that the
+ * product of a few of them stays a normal number: arithmetic on subnormal
+ * numbers is an order of magnitude slower on most processors. Same reduction
+ * as the double precision version, with a Taylor polynomial of degree 7.
+ * Twice as many of these are evaluated per vector instruction. */
+inline float
+Exp(float x)
+{
+  constexpr float log2e = 1.44269504f;
+  constexpr float ln2High = 0.693145752f;
+  constexpr float ln2Low = 1.42860677e-6f;
+  constexpr float shifter = 12582912.0f; // 1.5 * 2^23
+  constexpr float minimum = -27.0f;
+  constexpr float maximum = 88.0f;
+
+  const std::uint32_t underflow = NegativeMask(x - minimum);
+  float               clamped = Select(underflow, minimum, x);
+  clamped = Select(NegativeMask(maximum - clamped), maximum, clamped);
+
+  const float shifted = clamped * log2e + shifter;
+  const float k = shifted - shifter;
+  const float r = (clamped - k * ln2High) - k * ln2Low;
+
+  float p = 1.0f / 5040.0f;
+  p = p * r + 1.0f / 720.0f;
+  p = p * r + 1.0f / 120.0f;
+  p = p * r + 1.0f / 24.0f;
+  p = p * r + 1.0f / 6.0f;
+  p = p * r + 0.5f;
+  p = p * r + 1.0f;
+  p = p * r + 1.0f;
+
+  /* The low 9 bits of the shifted value hold k + 127 modulo 512 once the bias is added */
+  std::uint32_t bits;
+  std::memcpy(&bits, &shifted, sizeof(bits));
+  bits = (bits + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+
+  return Select(underflow, 0.0f, p * scale);
+}
+} // namespace EigenToMeasureMath
+} // namespace itk
+
+#endif // itkEigenToMeasureMath_h
@@ -22,6 +22,8 @@
 #include "itkStreamingImageFilter.h"
 #include "itkSimpleDataObjectDecorator.h"
 #include "itkSpatialObject.h"
+#include "itkSymmetricSecondRankTensor.h"
+#include "itkVoxelMask.h"
 
 namespace itk
 {
@@ -40,6 +42,31 @@ namespace itk
  * The method GetParametersOutput can be used to insert this filter in a pipeline before
  * EigenToMeasureImageFilter.
  *
+ * The input is passed through to the output for the measure filter downstream.
+ * When the input is computed in a single piece (see SetNumberOfStreamDivisions)
+ * and has the type of the output, the output shares the buffer of the input.
+ * Otherwise every piece is copied into the output. Subclasses only accumulate
+ * statistics over the pieces in DynamicThreadedGenerateData().
+ *
+ * With GenerateOutputImage off, the pieces are only accumulated and the
+ * output holds no pixel, so an input streamed in pieces is never buffered
+ * whole. The parameters can then be used by a measure reading the upstream
+ * filters again in a second pass.
+ *
+ * Every piece updates the upstream filters again, with their halo. When a
+ * MemoryBudget is set, the number of pieces is the smallest one for which a
+ * piece, with the UpstreamRadius on both sides, holds in the budget at
+ * UpstreamBytesPerPixel. Otherwise it is NumberOfStreamDivisions. An input
+ * already up to date and buffered over the requested region is never
+ * streamed.
+ *
+ * With a TargetRelativeError, the parameters estimated as means over the
+ * pixels are computed from a systematic sample of every block instead. A
+ * pilot sample of every piece gives the variance, hence the stride of the
+ * sample meeting the target at ConfidenceLevel. The half width of the
+ * confidence interval achieved on every parameter is given by
+ * GetParametersHalfWidthOutput().
+ *
  * \sa StreamingImageFilter
  * \sa MultiScaleHessianEnhancementImageFilter
  * \sa EigenToMeasureImageFilter
@@ -68,6 +95,7 @@ public:
   using InputImagePointer = typename InputImageType::Pointer;
   using InputImageConstPointer = typename InputImageType::ConstPointer;
   using InputImageRegionType = typename InputImageType::RegionType;
+  using InputImageIndexType = typename InputImageType::IndexType;
   using InputImagePixelType = typename InputImageType::PixelType;
   using PixelValueType = typename InputImagePixelType::ValueType;
   itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
@@ -92,6 +120,10 @@ public:
   const ParameterDecoratedType *
   GetParametersOutput() const;
 
+  /** Hessian typedefs, for the estimation from its invariants. */
+  using HessianPixelType = SymmetricSecondRankTensor<RealType, Self::ImageDimension>;
+  using HessianImageType = Image<HessianPixelType, Self::ImageDimension>;
+
   /** Standard getters for the parameters */
   ParameterArrayType
   GetParameters() const
@@ -99,10 +131,93 @@ public:
     return this->GetParametersOutput()->Get();
   }
 
+  /** Half width of the confidence interval at ConfidenceLevel of every
+   * parameter, 0 for the parameters computed from every pixel. */
+  ParameterDecoratedType *
+  GetParametersHalfWidthOutput();
+  const ParameterDecoratedType *
+  GetParametersHalfWidthOutput() const;
+
+  ParameterArrayType
+  GetParametersHalfWidth() const
+  {
+    return this->GetParametersHalfWidthOutput()->Get();
+  }
+
+  /** Set/Get the relative error within which the parameters estimated as
+   * means are computed from a sample of the pixels, at ConfidenceLevel.
+   * 0, the default, visits every pixel. */
+  itkSetClampMacro(TargetRelativeError, double, 0.0, NumericTraits<double>::max());
+  itkGetConstMacro(TargetRelativeError, double);
+
+  /** Set/Get the confidence level of the intervals on the parameters. */
+  itkSetClampMacro(ConfidenceLevel, double, 0.0, 0.999999);
+  itkGetConstMacro(ConfidenceLevel, double);
+
   /** Methods to set/get the mask image */
   itkSetInputMacro(Mask, MaskSpatialObjectType);
   itkGetInputMacro(Mask, MaskSpatialObjectType);
 
+  /** Set/Get the mask rasterized on the grid of the input. When it applies to
+   * the input it is used in place of Mask and only its runs of pixels are
+   * processed. Otherwise Mask is used. \sa VoxelMask::IsOnGridOf */
+  using VoxelMaskType = VoxelMask<Self::ImageDimension>;
+  itkSetConstObjectMacro(VoxelMask, VoxelMaskType);
+  itkGetConstObjectMacro(VoxelMask, VoxelMaskType);
+
+  /** Whether the parameters only depend on the trace and the Frobenius norm
+   * of the hessian, which are those of its eigenvalues. They can then be
+   * estimated from the hessian before its eigen analysis. */
+  virtual bool
+  CanEstimateFromHessianInvariants() const
+  {
+    return false;
+  }
+
+  /** Estimate the parameters from a region of a hessian image on the grid of
+   * the eigenvalues, without the eigenvalues. The mask and
+   * TargetRelativeError apply as they do to the input. Throws unless
+   * CanEstimateFromHessianInvariants().
+   *
+   * A hessian computed by a filter is updated over the region. With a
+   * MemoryBudget it is updated and reduced in the pieces of the budget,
+   * so only a piece of the hessian is buffered at a
+   * time. Without one it is updated at once and buffers the whole region,
+   * which a later update of the eigenvalues may reuse. A hessian without a
+   * source must buffer the region. */
+  void
+  EstimateFromHessianInvariants(HessianImageType * hessian, const InputImageRegionType & region);
+
+  /** Set/Get whether the input is passed through to the output. When off,
+   * the output is left empty and only the parameters are computed. Defaults
+   * to on. */
+  itkSetMacro(GenerateOutputImage, bool);
+  itkGetConstMacro(GenerateOutputImage, bool);
+  itkBooleanMacro(GenerateOutputImage);
+
+  /** Set/Get the memory in bytes the upstream filters may use for a piece,
+   * 0 to use NumberOfStreamDivisions instead. */
+  itkSetMacro(MemoryBudget, SizeValueType);
+  itkGetConstMacro(MemoryBudget, SizeValueType);
+
+  /** Set/Get the memory in bytes the upstream filters use per pixel of a
+   * piece. Defaults to the size of an input pixel. */
+  itkSetMacro(UpstreamBytesPerPixel, SizeValueType);
+  itkGetConstMacro(UpstreamBytesPerPixel, SizeValueType);
+
+  /** Set/Get the halo in pixels the upstream filters add around a piece. */
+  using InputImageSizeType = typename InputImageType::SizeType;
+  itkSetMacro(UpstreamRadius, InputImageSizeType);
+  itkGetConstReferenceMacro(UpstreamRadius, InputImageSizeType);
+
+  /** Get the number of pieces of the last update. */
+  itkGetConstMacro(NumberOfPieces, unsigned int);
+
+  /** Number of pieces to stream the region of the input in, before the
+   * splitter, from the memory budget or NumberOfStreamDivisions. */
+  unsigned int
+  ComputeNumberOfPieces(const InputImageRegionType & region) const;
+
   /** Override UpdateOutputData() from StreamingImageFilter to divide
    * upstream updates into pieces. This filter does not have a GenerateData()
    * or ThreadedGenerateData() method.  Instead, all the work is done
@@ -124,6 +239,87 @@ protected:
 
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Number of pieces the memory budget allows for the region, or
+   * NumberOfStreamDivisions without a budget. */
+  unsigned int
+  ComputeNumberOfPiecesOfBudget(const InputImageRegionType & region) const;
+
+  /** Accumulate the statistics of a region of the hessian, as
+   * DynamicThreadedGenerateData() does for a piece of the input. Only called
+   * when CanEstimateFromHessianInvariants(). */
+  virtual void
+  AccumulateHessianInvariants(const HessianImageType * hessian, const InputImageRegionType & region);
+
+  /** The voxel mask if it applies to the image, nullptr otherwise. */
+  const VoxelMaskType *
+  GetVoxelMaskOf(const ImageBase<Self::ImageDimension> * image) const
+  {
+    return m_VoxelMask && m_VoxelMask->IsOnGridOf(image) ? m_VoxelMask.GetPointer() : nullptr;
+  }
+
+  /** Quantile of the standard normal distribution bounding the intervals
+   * at ConfidenceLevel. */
+  double
+  GetConfidenceFactor() const;
+
+  /** Stride of a pilot sample of a few thousand pixels of the region. */
+  SizeValueType
+  ComputePilotStride(const InputImageRegionType & region) const;
+
+  /** Stride of the systematic sample of numberOfPixels pixels whose mean is
+   * within TargetRelativeError, given the mean and variance of the pixels
+   * estimated by a pilot sample. 1 without a target. */
+  SizeValueType
+  ComputeSamplingStride(double mean, double variance, double numberOfPixels) const;
+
+  /** Number of blocks ParallelizeBlocks() splits the region into. */
+  SizeValueType
+  ComputeNumberOfBlocks(const InputImageRegionType & region) const;
+
+  /** Number of rows of a slice of the region in a block, but for the last
+   * block of the slice. */
+  SizeValueType
+  ComputeRowsPerBlock(const InputImageRegionType & region) const;
+
+  /** Call function(block, blockRegion) for every block of the region, in
+   * parallel, each block on a single work unit. The blocks are the slices of
+   * the region along its last dimension, split along the dimension before it
+   * into blocks of whole rows of about 16384 pixels, so a few large slices
+   * still keep every work unit busy. The blocks only depend on the region, so
+   * partial results accumulated per block and merged in block order do not
+   * depend on the number of work units, unlike those of the pieces given by
+   * ParallelizeImageRegion. */
+  template <typename TFunction>
+  void
+  ParallelizeBlocks(const InputImageRegionType & region, TFunction && function);
+
+  /** Call visit(pixels, n) for every contiguous array of n pixels of the
+   * image, the input or the hessian, inside the mask, scanline by scanline in
+   * order. Without a mask, the scanlines are visited whole. */
+  template <typename TImage, typename TVisit>
+  void
+  VisitPixelsInsideMask(const TImage * image, const InputImageRegionType & region, TVisit && visit) const;
+
+  /** Call visit(pixel) for one pixel of the image inside the mask out of
+   * every stride, in scanline order starting with the pixel of rank phase. */
+  template <typename TImage, typename TVisit>
+  void
+  VisitSampledPixelsInsideMask(const TImage *               image,
+                               const InputImageRegionType & region,
+                               SizeValueType                stride,
+                               SizeValueType                phase,
+                               TVisit &&                    visit) const;
+
+private:
+  typename VoxelMaskType::ConstPointer m_VoxelMask;
+  bool                                 m_GenerateOutputImage{ true };
+  SizeValueType                        m_MemoryBudget{ 0 };
+  SizeValueType                        m_UpstreamBytesPerPixel{ sizeof(InputImagePixelType) };
+  InputImageSizeType                   m_UpstreamRadius;
+  unsigned int                         m_NumberOfPieces{ 0 };
+  double                               m_TargetRelativeError{ 0.0 };
+  double                               m_ConfidenceLevel{ 0.95 };
 }; // end class
 } // namespace itk
 
@@ -20,10 +20,13 @@
 #define itkEigenToMeasureParameterEstimationFilter_hxx
 
 #include "itkCommand.h"
+#include "itkGaussianDistribution.h"
 #include "itkImageAlgorithm.h"
 #include "itkImageRegionSplitterSlowDimension.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkImageScanlineConstIterator.h"
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -34,11 +37,17 @@ EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::EigenToMeasu
   /* Set stream parameters */
   this->SetNumberOfStreamDivisions(10);
   this->SetRegionSplitter(ImageRegionSplitterSlowDimension::New());
+  m_UpstreamRadius.Fill(0);
 
   /* Allocate parameterset decorator */
   typename ParameterDecoratedType::Pointer output = ParameterDecoratedType::New().GetPointer();
   this->ProcessObject::SetNthOutput(1, output.GetPointer());
   this->GetParametersOutput()->Set(ParameterArrayType());
+
+  /* Allocate the decorator of the confidence intervals */
+  typename ParameterDecoratedType::Pointer halfWidthOutput = ParameterDecoratedType::New().GetPointer();
+  this->ProcessObject::SetNthOutput(2, halfWidthOutput.GetPointer());
+  this->GetParametersHalfWidthOutput()->Set(ParameterArrayType());
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -73,29 +82,51 @@ EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::UpdateOutput
   this->UpdateProgress(0.0);
   this->m_Updating = true;
 
-  /** Allocate the output buffer. */
   OutputImageType *           outputPtr = this->GetOutput(0);
   const OutputImageRegionType outputRegion = outputPtr->GetRequestedRegion();
-  outputPtr->SetBufferedRegion(outputRegion);
-  outputPtr->Allocate();
 
   /** Grab the input */
   auto * inputPtr = const_cast<InputImageType *>(this->GetInput(0));
 
   /**
    * Determine of number of pieces to divide the input.  This will be the
-   * minimum of what the user specified via SetNumberOfStreamDivisions()
-   * and what the Splitter thinks is a reasonable value.
+   * minimum of what the memory budget or the user specified via
+   * SetNumberOfStreamDivisions() allows and what the Splitter thinks is a
+   * reasonable value.
    */
   unsigned int numDivisions, numDivisionsFromSplitter;
 
-  numDivisions = this->GetNumberOfStreamDivisions();
-  numDivisionsFromSplitter =
-    this->GetRegionSplitter()->GetNumberOfSplits(outputRegion, this->GetNumberOfStreamDivisions());
+  InputImageRegionType inputRegion;
+  this->CallCopyOutputRegionToInputRegion(inputRegion, outputRegion);
+  numDivisions = this->ComputeNumberOfPieces(inputRegion);
+  numDivisionsFromSplitter = this->GetRegionSplitter()->GetNumberOfSplits(outputRegion, numDivisions);
   if (numDivisionsFromSplitter < numDivisions)
   {
     numDivisions = numDivisionsFromSplitter;
   }
+  m_NumberOfPieces = numDivisions;
+
+  /**
+   * An input computed in one piece is passed through by sharing its buffer
+   * when it has the type of the output. Otherwise allocate the output buffer
+   * and copy every piece into it. Without an output image, the output holds
+   * no pixel.
+   */
+  auto *     passThroughImage = dynamic_cast<OutputImageType *>(inputPtr);
+  const bool shareBuffer = m_GenerateOutputImage && numDivisions == 1 && passThroughImage != nullptr;
+  if (!m_GenerateOutputImage)
+  {
+    outputPtr->SetBufferedRegion(OutputImageRegionType(outputRegion.GetIndex(), typename OutputImageType::SizeType()));
+    outputPtr->Allocate();
+  }
+  else if (!shareBuffer)
+  {
+    outputPtr->SetBufferedRegion(outputRegion);
+    outputPtr->Allocate();
+  }
+
+  /* Work units of this filter, the blocks of a piece are processed in parallel */
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
 
   // Call a method that can be overridden by a subclass to perform
   // some calculations prior to splitting the main computations into
@@ -120,6 +151,18 @@ EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::UpdateOutput
     /* Process this chunk */
     this->ThreadedGenerateData(streamRegion, piece);
 
+    /* Pass it through */
+    if (shareBuffer)
+    {
+      outputPtr->Graft(passThroughImage);
+    }
+    else if (m_GenerateOutputImage)
+    {
+      OutputImageRegionType outputPieceRegion;
+      this->CallCopyInputRegionToOutputRegion(outputPieceRegion, streamRegion);
+      ImageAlgorithm::Copy(inputPtr, outputPtr, streamRegion, outputPieceRegion);
+    }
+
     /* Update progress and stream another chunk */
     this->UpdateProgress(static_cast<float>(piece) / static_cast<float>(numDivisions));
   }
@@ -170,11 +213,309 @@ EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::GetParameter
   return static_cast<const ParameterDecoratedType *>(this->ProcessObject::GetOutput(1));
 }
 
+template <typename TInputImage, typename TOutputImage>
+unsigned int
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ComputeNumberOfPieces(
+  const InputImageRegionType & region) const
+{
+  /* Updating an input already buffered would only copy it piece by piece */
+  const InputImageType * input = this->GetInput();
+  const bool             upToDate = input->GetSource() == nullptr ||
+                        (!input->GetDataReleased() && input->GetUpdateMTime() >= input->GetPipelineMTime());
+  if (upToDate && input->GetBufferedRegion().IsInside(region))
+  {
+    return 1;
+  }
+  return this->ComputeNumberOfPiecesOfBudget(region);
+}
+
+template <typename TInputImage, typename TOutputImage>
+unsigned int
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ComputeNumberOfPiecesOfBudget(
+  const InputImageRegionType & region) const
+{
+  if (m_MemoryBudget == 0)
+  {
+    return this->GetNumberOfStreamDivisions();
+  }
+
+  /* The pieces are slabs of whole slices along the last dimension, padded by
+   * the halo on every side */
+  constexpr unsigned int sliceDimension = ImageDimension - 1;
+  SizeValueType          sliceBytes = std::max<SizeValueType>(m_UpstreamBytesPerPixel, 1);
+  for (unsigned int i = 0; i < sliceDimension; ++i)
+  {
+    sliceBytes *= region.GetSize(i) + 2 * m_UpstreamRadius[i];
+  }
+  const SizeValueType numberOfSlices = region.GetSize(sliceDimension);
+  const SizeValueType paddedSlices = m_MemoryBudget / sliceBytes;
+  const SizeValueType haloSlices = 2 * m_UpstreamRadius[sliceDimension];
+
+  /* A piece holds at least one slice, even over the budget */
+  const SizeValueType slicesPerPiece = paddedSlices > haloSlices + 1 ? paddedSlices - haloSlices : 1;
+  const SizeValueType numberOfPieces = (numberOfSlices + slicesPerPiece - 1) / slicesPerPiece;
+  return static_cast<unsigned int>(
+    std::min<SizeValueType>(std::max<SizeValueType>(numberOfPieces, 1), NumericTraits<unsigned int>::max()));
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::EstimateFromHessianInvariants(
+  HessianImageType *           hessian,
+  const InputImageRegionType & region)
+{
+  if (!hessian)
+  {
+    itkExceptionMacro(<< "A hessian image is required to estimate the parameters from its invariants.");
+  }
+  const bool computed = hessian->GetSource() != nullptr;
+  if (!computed && !hessian->GetBufferedRegion().IsInside(region))
+  {
+    itkExceptionMacro(<< "Region " << region << " is not buffered by the hessian image.");
+  }
+  if (!this->CanEstimateFromHessianInvariants())
+  {
+    itkExceptionMacro(<< this->GetNameOfClass() << " cannot estimate its parameters from the hessian invariants.");
+  }
+
+  /* The pieces are the strata of a sample, as those of the input are */
+  unsigned int numberOfPieces = 1;
+  if (computed && m_MemoryBudget > 0)
+  {
+    numberOfPieces =
+      this->GetRegionSplitter()->GetNumberOfSplits(region, this->ComputeNumberOfPiecesOfBudget(region));
+  }
+  m_NumberOfPieces = numberOfPieces;
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  this->BeforeThreadedGenerateData();
+  for (unsigned int piece = 0; piece < numberOfPieces; ++piece)
+  {
+    InputImageRegionType pieceRegion = region;
+    this->GetRegionSplitter()->GetSplit(piece, numberOfPieces, pieceRegion);
+    if (computed)
+    {
+      hessian->SetRequestedRegion(pieceRegion);
+      hessian->Update();
+    }
+    this->AccumulateHessianInvariants(hessian, pieceRegion);
+  }
+  this->AfterThreadedGenerateData();
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AccumulateHessianInvariants(
+  const HessianImageType *,
+  const InputImageRegionType &)
+{
+  itkExceptionMacro(<< this->GetNameOfClass() << " cannot estimate its parameters from the hessian invariants.");
+}
+
+template <typename TInputImage, typename TOutputImage>
+double
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::GetConfidenceFactor() const
+{
+  return Statistics::GaussianDistribution::InverseCDF(0.5 + 0.5 * m_ConfidenceLevel);
+}
+
+template <typename TInputImage, typename TOutputImage>
+SizeValueType
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ComputePilotStride(
+  const InputImageRegionType & region) const
+{
+  constexpr SizeValueType pilotSampleSize = 4096;
+  return std::max<SizeValueType>(region.GetNumberOfPixels() / pilotSampleSize, 1);
+}
+
+template <typename TInputImage, typename TOutputImage>
+SizeValueType
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ComputeSamplingStride(double mean,
+                                                                                          double variance,
+                                                                                          double numberOfPixels) const
+{
+  if (m_TargetRelativeError <= 0.0 || mean == 0.0)
+  {
+    return 1;
+  }
+
+  /* The half width of the interval on the mean of n samples is z * sigma / sqrt(n) */
+  const double halfWidth = m_TargetRelativeError * std::abs(mean) / this->GetConfidenceFactor();
+  const double numberOfSamples = std::max(variance / (halfWidth * halfWidth), 1.0);
+  return static_cast<SizeValueType>(std::max(std::floor(numberOfPixels / numberOfSamples), 1.0));
+}
+
+template <typename TInputImage, typename TOutputImage>
+SizeValueType
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ComputeNumberOfBlocks(
+  const InputImageRegionType & region) const
+{
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return 0;
+  }
+
+  constexpr unsigned int sliceDimension = ImageDimension - 1;
+  constexpr unsigned int rowDimension = ImageDimension > 1 ? ImageDimension - 2 : 0;
+  const SizeValueType    rowsPerBlock = this->ComputeRowsPerBlock(region);
+  const SizeValueType    numberOfRows = sliceDimension > rowDimension ? region.GetSize(rowDimension) : 1;
+  return region.GetSize(sliceDimension) * ((numberOfRows + rowsPerBlock - 1) / rowsPerBlock);
+}
+
+template <typename TInputImage, typename TOutputImage>
+SizeValueType
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ComputeRowsPerBlock(
+  const InputImageRegionType & region) const
+{
+  /* The rows of a slice are along the dimension before the last, a block holds at least one */
+  constexpr SizeValueType blockNumberOfPixels = 16384;
+  constexpr unsigned int  rowDimension = ImageDimension > 1 ? ImageDimension - 2 : 0;
+  SizeValueType           rowNumberOfPixels = 1;
+  for (unsigned int i = 0; i < rowDimension; ++i)
+  {
+    rowNumberOfPixels *= region.GetSize(i);
+  }
+  return std::max<SizeValueType>(blockNumberOfPixels / std::max<SizeValueType>(rowNumberOfPixels, 1), 1);
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TFunction>
+void
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ParallelizeBlocks(
+  const InputImageRegionType & region,
+  TFunction &&                 function)
+{
+  const SizeValueType numberOfBlocks = this->ComputeNumberOfBlocks(region);
+  if (numberOfBlocks == 0)
+  {
+    return;
+  }
+
+  constexpr unsigned int sliceDimension = ImageDimension - 1;
+  constexpr unsigned int rowDimension = ImageDimension > 1 ? ImageDimension - 2 : 0;
+  const SizeValueType    blocksPerSlice = numberOfBlocks / region.GetSize(sliceDimension);
+  const SizeValueType    numberOfRows = sliceDimension > rowDimension ? region.GetSize(rowDimension) : 1;
+  const SizeValueType    rowsPerBlock = this->ComputeRowsPerBlock(region);
+
+  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
+  mt->ParallelizeArray(
+    0,
+    numberOfBlocks,
+    [&region, &function, blocksPerSlice, numberOfRows, rowsPerBlock](SizeValueType block) {
+      const SizeValueType  slice = block / blocksPerSlice;
+      InputImageRegionType blockRegion = region;
+      blockRegion.SetIndex(sliceDimension, region.GetIndex(sliceDimension) + static_cast<IndexValueType>(slice));
+      blockRegion.SetSize(sliceDimension, 1);
+      if (sliceDimension > rowDimension)
+      {
+        const SizeValueType firstRow = (block % blocksPerSlice) * rowsPerBlock;
+        blockRegion.SetIndex(rowDimension, region.GetIndex(rowDimension) + static_cast<IndexValueType>(firstRow));
+        blockRegion.SetSize(rowDimension, std::min(rowsPerBlock, numberOfRows - firstRow));
+      }
+      function(block, blockRegion);
+    },
+    nullptr);
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage, typename TVisit>
+void
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::VisitPixelsInsideMask(
+  const TImage *               image,
+  const InputImageRegionType & region,
+  TVisit &&                    visit) const
+{
+  using PixelType = typename TImage::PixelType;
+  const MaskSpatialObjectType * maskPointer = this->GetMask();
+  const VoxelMaskType *         voxelMask = this->GetVoxelMaskOf(image);
+
+  typename TImage::PointType point;
+
+  ImageScanlineConstIterator<TImage> imageIt(image, region);
+  const SizeValueType                lineLength = region.GetSize(0);
+  while (!imageIt.IsAtEnd())
+  {
+    const InputImageIndexType lineIndex = imageIt.GetIndex();
+    const PixelType *         line = image->GetBufferPointer() + image->ComputeOffset(lineIndex);
+
+    // Process the runs inside the mask
+    if (voxelMask)
+    {
+      voxelMask->VisitRuns(lineIndex, lineLength, [&](IndexValueType start, SizeValueType length) {
+        visit(line + (start - lineIndex[0]), length);
+      });
+    }
+    else if (maskPointer)
+    {
+      for (SizeValueType i = 0; i < lineLength; ++i)
+      {
+        InputImageIndexType index = lineIndex;
+        index[0] += static_cast<IndexValueType>(i);
+        image->TransformIndexToPhysicalPoint(index, point);
+        if (maskPointer->IsInsideInObjectSpace(point))
+        {
+          visit(line + i, 1);
+        }
+      }
+    }
+    else
+    {
+      visit(line, lineLength);
+    }
+
+    imageIt.NextLine();
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage, typename TVisit>
+void
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::VisitSampledPixelsInsideMask(
+  const TImage *               image,
+  const InputImageRegionType & region,
+  SizeValueType                stride,
+  SizeValueType                phase,
+  TVisit &&                    visit) const
+{
+  /* Number of pixels to skip before the next sample, carried over the runs */
+  SizeValueType skip = phase % stride;
+  this->VisitPixelsInsideMask(image, region, [&](const typename TImage::PixelType * pixels, SizeValueType n) {
+    SizeValueType i = skip;
+    for (; i < n; i += stride)
+    {
+      visit(pixels[i]);
+    }
+    skip = i - n;
+  });
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ParameterDecoratedType *
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::GetParametersHalfWidthOutput()
+{
+  return static_cast<ParameterDecoratedType *>(this->ProcessObject::GetOutput(2));
+}
+
+template <typename TInputImage, typename TOutputImage>
+const typename EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::ParameterDecoratedType *
+EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::GetParametersHalfWidthOutput() const
+{
+  return static_cast<const ParameterDecoratedType *>(this->ProcessObject::GetOutput(2));
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 EigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "VoxelMask: " << m_VoxelMask.GetPointer() << std::endl;
+  os << indent << "GenerateOutputImage: " << m_GenerateOutputImage << std::endl;
+  os << indent << "MemoryBudget: " << m_MemoryBudget << std::endl;
+  os << indent << "UpstreamBytesPerPixel: " << m_UpstreamBytesPerPixel << std::endl;
+  os << indent << "UpstreamRadius: " << m_UpstreamRadius << std::endl;
+  os << indent << "NumberOfPieces: " << m_NumberOfPieces << std::endl;
+  os << indent << "TargetRelativeError: " << m_TargetRelativeError << std::endl;
+  os << indent << "ConfidenceLevel: " << m_ConfidenceLevel << std::endl;
 }
 
 } // end namespace itk
@@ -0,0 +1,230 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkHessianGaussianCostModel_h
+#define itkHessianGaussianCostModel_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkHessianGaussianImageFilter.h"
+#include <string>
+
+namespace itk
+{
+/** \class HessianGaussianCostModel
+ * \brief Predicts the run time of the convolution backends of HessianGaussianImageFilter.
+ *
+ * The cost of each backend is modeled as a fixed overhead plus a
+ * coefficient times a measure of the work it does:
+ *  - Discrete: number of pixels of the region times the sum over the
+ *    dimensions of the kernel widths, which grow linearly with sigma over the
+ *    spacing.
+ *  - Recursive: number of pixels of the region, independent of sigma.
+ *  - FFT: M log2(M) where M is the number of pixels of the padded grid, as
+ *    the whole grid is transformed whatever the region. When the forward
+ *    transform is already available only the inverse transforms are counted.
+ * The overhead accounts for the passes, the allocations and the threading,
+ * which dominate on small images.
+ *
+ * The overheads and coefficients depend on the machine and on the number of
+ * work units. Calibrate() measures them once by timing each backend on
+ * synthetic images of half and of full CalibrationImageSize, each at a small
+ * and a larger sigma so the size and the sigma vary independently, and
+ * fitting a line through the four run times by least squares. They are read
+ * from the calibration file if it holds a calibration for the same image
+ * dimension and number of work units, and appended to it otherwise. The file
+ * defaults to one per user, so the calibration is measured once rather than
+ * in every process. Each line of the file holds the dimension, the number of
+ * work units and the overhead and coefficient in seconds of the Discrete,
+ * Recursive and FFT backends. Lines in another format are ignored.
+ *
+ * \sa HessianGaussianImageFilter
+ * \sa MultiScaleHessianEnhancementImageFilter
+ *
+ * \ingroup BoneEnhancement
+ */
+template <typename TInputImage>
+class ITK_TEMPLATE_EXPORT HessianGaussianCostModel : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HessianGaussianCostModel);
+
+  /** Standard Self typedef */
+  using Self = HessianGaussianCostModel;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HessianGaussianCostModel, Object);
+
+  /** Image dimension. */
+  itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+  /** Image related typedefs. */
+  using InputImageType = TInputImage;
+  using SizeType = typename TInputImage::SizeType;
+  using SpacingType = typename TInputImage::SpacingType;
+
+  /** Hessian related typedefs. */
+  using HessianFilterType = HessianGaussianImageFilter<TInputImage>;
+  using ConvolutionBackendEnum = typename HessianFilterType::ConvolutionBackendEnum;
+  using RealType = typename HessianFilterType::RealType;
+
+  /** Set/Get the file the calibration is stored in. Defaults to
+   * GetDefaultCalibrationFileName(). No file is used when empty. Machines
+   * sharing a home directory should each be given their own file. */
+  itkSetStringMacro(CalibrationFileName);
+  itkGetStringMacro(CalibrationFileName);
+
+  /** The calibration file of the user, BoneEnhancementHessianGaussianCostModel.txt
+   * in the .itk directory of the home directory, or the application data
+   * directory on Windows. Empty when that directory is unknown. */
+  static std::string
+  GetDefaultCalibrationFileName();
+
+  /** Set/Get the number of work units the backends will run with. */
+  itkSetMacro(NumberOfWorkUnits, unsigned int);
+  itkGetConstMacro(NumberOfWorkUnits, unsigned int);
+
+  /** Set/Get the kernel parameters of the discrete backend.
+   * \sa HessianGaussianImageFilter::SetMaximumError
+   * \sa HessianGaussianImageFilter::SetMaximumKernelWidth */
+  itkSetMacro(MaximumError, double);
+  itkGetConstMacro(MaximumError, double);
+  itkSetMacro(MaximumKernelWidth, unsigned int);
+  itkGetConstMacro(MaximumKernelWidth, unsigned int);
+
+  /** Set/Get the edge length of the synthetic image used for calibration. */
+  itkSetMacro(CalibrationImageSize, SizeValueType);
+  itkGetConstMacro(CalibrationImageSize, SizeValueType);
+
+  /** Get the calibrated coefficient of a backend, in seconds per unit of work. */
+  double
+  GetCoefficient(ConvolutionBackendEnum backend) const;
+
+  /** Get the calibrated overhead of a backend, in seconds. */
+  double
+  GetOverhead(ConvolutionBackendEnum backend) const;
+
+  /** True once the coefficients match the current number of work units. */
+  bool
+  IsCalibrated() const;
+
+  /** Load the coefficients from the calibration file or measure them. Does
+   * nothing when already calibrated for the current number of work units. */
+  void
+  Calibrate();
+
+  /** Predicted run time in seconds of a backend for one sigma, computing the
+   * hessian on a region of the given size of a grid of the given size. */
+  double
+  EstimateCost(ConvolutionBackendEnum backend,
+               RealType               sigma,
+               const SizeType &       size,
+               const SizeType &       gridSize,
+               const SpacingType &    spacing,
+               bool                   forwardTransformAvailable = false) const;
+
+  /** Predicted run time in seconds of a backend for one sigma, computing the
+   * hessian on the whole grid. */
+  double
+  EstimateCost(ConvolutionBackendEnum backend,
+               RealType               sigma,
+               const SizeType &       size,
+               const SpacingType &    spacing,
+               bool                   forwardTransformAvailable = false) const;
+
+  /** Backend with the lowest predicted run time for one sigma, computing the
+   * hessian on a region of the given size of a grid of the given size. */
+  ConvolutionBackendEnum
+  SelectBackend(RealType            sigma,
+                const SizeType &    size,
+                const SizeType &    gridSize,
+                const SpacingType & spacing,
+                bool                forwardTransformAvailable = false) const;
+
+  /** Backend with the lowest predicted run time for one sigma, computing the
+   * hessian on the whole grid. */
+  ConvolutionBackendEnum
+  SelectBackend(RealType            sigma,
+                const SizeType &    size,
+                const SpacingType & spacing,
+                bool                forwardTransformAvailable = false) const;
+
+  /** Predicted run time in seconds of smoothing the whole grid by a Gaussian
+   * with separable discrete kernels, as done before downsampling. Derived
+   * from the calibration of the discrete backend. */
+  double
+  EstimateSmoothingCost(RealType sigma, const SizeType & size, const SpacingType & spacing) const;
+
+protected:
+  HessianGaussianCostModel();
+  ~HessianGaussianCostModel() override = default;
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Amount of work of a backend, the coefficient and the overhead excluded. */
+  double
+  GetWork(ConvolutionBackendEnum backend,
+          RealType               sigma,
+          const SizeType &       size,
+          const SizeType &       gridSize,
+          const SpacingType &    spacing,
+          bool                   forwardTransformAvailable) const;
+
+  /** Read the coefficients matching the dimension and the number of work units. */
+  bool
+  ReadCalibration();
+
+  /** Append the coefficients to the calibration file. */
+  void
+  WriteCalibration() const;
+
+  /** Time each backend on two synthetic images at two sigmas. */
+  void
+  MeasureCoefficients();
+
+  /** Fastest of a few runs of the hessian filter, in seconds. */
+  static double
+  MeasureRunTime(HessianFilterType * hessianFilter);
+
+private:
+  static constexpr unsigned int NumberOfBackends = 3;
+
+  std::string   m_CalibrationFileName;
+  unsigned int  m_NumberOfWorkUnits;
+  double        m_MaximumError;
+  unsigned int  m_MaximumKernelWidth;
+  SizeValueType m_CalibrationImageSize;
+
+  /** Overheads and coefficients indexed by backend, and the work units they were measured with */
+  double       m_Overheads[NumberOfBackends];
+  double       m_Coefficients[NumberOfBackends];
+  unsigned int m_CalibratedNumberOfWorkUnits;
+}; // end class
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHessianGaussianCostModel.hxx"
+#endif
+
+#endif // itkHessianGaussianCostModel_h
@@ -0,0 +1,488 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkHessianGaussianCostModel_hxx
+#define itkHessianGaussianCostModel_hxx
+
+#include "itkMultiThreaderBase.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include "itksys/SystemTools.hxx"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+template <typename TInputImage>
+HessianGaussianCostModel<TInputImage>::HessianGaussianCostModel()
+  : m_CalibrationFileName(Self::GetDefaultCalibrationFileName())
+  , m_NumberOfWorkUnits(MultiThreaderBase::GetGlobalDefaultNumberOfThreads())
+  , m_MaximumError(0.01)
+  , m_MaximumKernelWidth(32)
+  , m_CalibrationImageSize(ImageDimension == 2 ? 256 : 48)
+  , m_CalibratedNumberOfWorkUnits(0)
+{
+  for (unsigned int i = 0; i < NumberOfBackends; ++i)
+  {
+    m_Overheads[i] = 0.0;
+    m_Coefficients[i] = 0.0;
+  }
+}
+
+template <typename TInputImage>
+std::string
+HessianGaussianCostModel<TInputImage>::GetDefaultCalibrationFileName()
+{
+  std::string directory;
+#if defined(_WIN32)
+  if (!itksys::SystemTools::GetEnv("APPDATA", directory) || directory.empty())
+#else
+  if (!itksys::SystemTools::GetEnv("HOME", directory) || directory.empty())
+#endif
+  {
+    return "";
+  }
+  return directory + "/.itk/BoneEnhancementHessianGaussianCostModel.txt";
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::GetCoefficient(ConvolutionBackendEnum backend) const
+{
+  const unsigned int index = static_cast<unsigned int>(backend);
+  if (index >= NumberOfBackends)
+  {
+    itkExceptionMacro(<< "Unknown convolution backend " << index);
+  }
+  return m_Coefficients[index];
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::GetOverhead(ConvolutionBackendEnum backend) const
+{
+  const unsigned int index = static_cast<unsigned int>(backend);
+  if (index >= NumberOfBackends)
+  {
+    itkExceptionMacro(<< "Unknown convolution backend " << index);
+  }
+  return m_Overheads[index];
+}
+
+template <typename TInputImage>
+bool
+HessianGaussianCostModel<TInputImage>::IsCalibrated() const
+{
+  return m_CalibratedNumberOfWorkUnits != 0 && m_CalibratedNumberOfWorkUnits == m_NumberOfWorkUnits;
+}
+
+template <typename TInputImage>
+void
+HessianGaussianCostModel<TInputImage>::Calibrate()
+{
+  if (this->IsCalibrated())
+  {
+    return;
+  }
+
+  if (this->ReadCalibration())
+  {
+    return;
+  }
+
+  this->MeasureCoefficients();
+  this->WriteCalibration();
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::GetWork(ConvolutionBackendEnum backend,
+                                               RealType               sigma,
+                                               const SizeType &       size,
+                                               const SizeType &       gridSize,
+                                               const SpacingType &    spacing,
+                                               bool                   forwardTransformAvailable) const
+{
+  double numberOfPixels = 1.0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    numberOfPixels *= size[i];
+  }
+
+  switch (backend)
+  {
+    case ConvolutionBackendEnum::Discrete:
+    {
+      // Same kernels as HessianGaussianImageFilter::CreateOperator(), the
+      // second order one being the widest
+      double kernelWidths = 0.0;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        typename HessianFilterType::OperatorType oper;
+        oper.SetDirection(i);
+        oper.SetOrder(2);
+        oper.SetSpacing(spacing[i]);
+        oper.SetNormalizeAcrossScale(false);
+        oper.SetVariance(sigma * sigma);
+        oper.SetMaximumError(m_MaximumError);
+        oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+        oper.CreateDirectional();
+        kernelWidths += oper.Size();
+      }
+      return numberOfPixels * kernelWidths;
+    }
+    case ConvolutionBackendEnum::Recursive:
+      return numberOfPixels;
+    case ConvolutionBackendEnum::FFT:
+    {
+      // The whole grid is transformed, with the padding of
+      // HessianGaussianImageFilter::GetFFTPadding()
+      double numberOfPaddedPixels = 1.0;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        numberOfPaddedPixels *= gridSize[i] + 2.0 * std::ceil(4.0 * sigma / spacing[i]);
+      }
+      const double numberOfComponents = ImageDimension * (ImageDimension + 1) / 2;
+      const double numberOfTransforms = forwardTransformAvailable ? numberOfComponents : numberOfComponents + 1.0;
+      return numberOfTransforms * numberOfPaddedPixels * std::log2(numberOfPaddedPixels);
+    }
+    default:
+      break;
+  }
+
+  itkExceptionMacro(<< "Unknown convolution backend " << static_cast<int>(backend));
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::EstimateCost(ConvolutionBackendEnum backend,
+                                                    RealType               sigma,
+                                                    const SizeType &       size,
+                                                    const SizeType &       gridSize,
+                                                    const SpacingType &    spacing,
+                                                    bool                   forwardTransformAvailable) const
+{
+  const double work = this->GetWork(backend, sigma, size, gridSize, spacing, forwardTransformAvailable);
+  return this->GetOverhead(backend) + this->GetCoefficient(backend) * work;
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::EstimateCost(ConvolutionBackendEnum backend,
+                                                    RealType               sigma,
+                                                    const SizeType &       size,
+                                                    const SpacingType &    spacing,
+                                                    bool                   forwardTransformAvailable) const
+{
+  return this->EstimateCost(backend, sigma, size, size, spacing, forwardTransformAvailable);
+}
+
+template <typename TInputImage>
+typename HessianGaussianCostModel<TInputImage>::ConvolutionBackendEnum
+HessianGaussianCostModel<TInputImage>::SelectBackend(RealType            sigma,
+                                                     const SizeType &    size,
+                                                     const SpacingType & spacing,
+                                                     bool                forwardTransformAvailable) const
+{
+  return this->SelectBackend(sigma, size, size, spacing, forwardTransformAvailable);
+}
+
+template <typename TInputImage>
+typename HessianGaussianCostModel<TInputImage>::ConvolutionBackendEnum
+HessianGaussianCostModel<TInputImage>::SelectBackend(RealType            sigma,
+                                                     const SizeType &    size,
+                                                     const SizeType &    gridSize,
+                                                     const SpacingType & spacing,
+                                                     bool                forwardTransformAvailable) const
+{
+  if (!this->IsCalibrated())
+  {
+    itkExceptionMacro(<< "The cost model must be calibrated before selecting a backend");
+  }
+
+  ConvolutionBackendEnum bestBackend = ConvolutionBackendEnum::Discrete;
+  double bestCost = this->EstimateCost(bestBackend, sigma, size, gridSize, spacing, forwardTransformAvailable);
+  for (unsigned int i = 1; i < NumberOfBackends; ++i)
+  {
+    const auto   backend = static_cast<ConvolutionBackendEnum>(i);
+    const double cost = this->EstimateCost(backend, sigma, size, gridSize, spacing, forwardTransformAvailable);
+    if (cost < bestCost)
+    {
+      bestBackend = backend;
+      bestCost = cost;
+    }
+  }
+
+  itkDebugMacro(<< "Selected backend " << static_cast<int>(bestBackend) << " for sigma " << sigma);
+  return bestBackend;
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::EstimateSmoothingCost(RealType            sigma,
+                                                             const SizeType &    size,
+                                                             const SpacingType & spacing) const
+{
+  /* The work of the discrete backend counts every dimension once, but its tree of passes runs one pass per
+   * combination of orders of the dimensions up to the current one, 15 passes in 3D. Smoothing runs one pass per
+   * dimension. */
+  double numberOfPasses = ImageDimension * (ImageDimension + 1) / 2;
+  for (unsigned int i = 1; i < ImageDimension; ++i)
+  {
+    numberOfPasses += (i + 1) * (i + 2) / 2;
+  }
+
+  double numberOfPixels = 1.0;
+  double kernelWidths = 0.0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    typename HessianFilterType::OperatorType oper;
+    oper.SetDirection(i);
+    oper.SetOrder(0);
+    oper.SetSpacing(spacing[i]);
+    oper.SetNormalizeAcrossScale(false);
+    oper.SetVariance(sigma * sigma);
+    oper.SetMaximumError(m_MaximumError);
+    oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+    oper.CreateDirectional();
+    kernelWidths += oper.Size();
+    numberOfPixels *= size[i];
+  }
+
+  const auto discrete = ConvolutionBackendEnum::Discrete;
+  return this->GetOverhead(discrete) +
+         this->GetCoefficient(discrete) * numberOfPixels * kernelWidths * ImageDimension / numberOfPasses;
+}
+
+template <typename TInputImage>
+bool
+HessianGaussianCostModel<TInputImage>::ReadCalibration()
+{
+  if (m_CalibrationFileName.empty())
+  {
+    return false;
+  }
+
+  std::ifstream file(m_CalibrationFileName.c_str());
+  if (!file)
+  {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    std::istringstream record(line);
+    unsigned int       dimension = 0;
+    unsigned int       numberOfWorkUnits = 0;
+    double             overheads[NumberOfBackends];
+    double             coefficients[NumberOfBackends];
+    record >> dimension >> numberOfWorkUnits;
+    for (unsigned int i = 0; i < NumberOfBackends; ++i)
+    {
+      record >> overheads[i] >> coefficients[i];
+    }
+
+    if (!record || dimension != ImageDimension || numberOfWorkUnits != m_NumberOfWorkUnits)
+    {
+      continue;
+    }
+
+    for (unsigned int i = 0; i < NumberOfBackends; ++i)
+    {
+      m_Overheads[i] = overheads[i];
+      m_Coefficients[i] = coefficients[i];
+    }
+    m_CalibratedNumberOfWorkUnits = m_NumberOfWorkUnits;
+    this->Modified();
+    return true;
+  }
+
+  return false;
+}
+
+template <typename TInputImage>
+void
+HessianGaussianCostModel<TInputImage>::WriteCalibration() const
+{
+  if (m_CalibrationFileName.empty())
+  {
+    return;
+  }
+
+  /* The directory of the default file may not exist yet */
+  const std::string directory = itksys::SystemTools::GetFilenamePath(m_CalibrationFileName);
+  if (!directory.empty())
+  {
+    itksys::SystemTools::MakeDirectory(directory);
+  }
+
+  std::ofstream file(m_CalibrationFileName.c_str(), std::ios::app);
+  if (!file)
+  {
+    itkWarningMacro(<< "Cannot write the calibration to " << m_CalibrationFileName);
+    return;
+  }
+
+  file.precision(17);
+  file << ImageDimension << " " << m_NumberOfWorkUnits;
+  for (unsigned int i = 0; i < NumberOfBackends; ++i)
+  {
+    file << " " << m_Overheads[i] << " " << m_Coefficients[i];
+  }
+  file << std::endl;
+}
+
+template <typename TInputImage>
+void
+HessianGaussianCostModel<TInputImage>::MeasureCoefficients()
+{
+  /* Synthetic images, the run time does not depend on their content. Every size is timed at every sigma, so the
+   * work of the discrete and FFT backends varies with each of them independently. */
+  constexpr unsigned int numberOfEdges = 2;
+  constexpr unsigned int numberOfSigmas = 2;
+  constexpr unsigned int numberOfSamples = numberOfEdges * numberOfSigmas;
+  const SizeValueType    edges[numberOfEdges] = { std::max<SizeValueType>(m_CalibrationImageSize / 2, 1),
+                                               m_CalibrationImageSize };
+  const RealType         sigmas[numberOfSigmas] = { 1.0, 2.0 };
+
+  double       works[numberOfSamples][NumberOfBackends];
+  double       times[numberOfSamples][NumberOfBackends];
+  unsigned int sample = 0;
+  for (const SizeValueType edge : edges)
+  {
+    SizeType size;
+    size.Fill(edge);
+    typename TInputImage::Pointer image = TInputImage::New();
+    image->SetRegions(typename TInputImage::RegionType(size));
+    image->Allocate();
+
+    unsigned int                     seed = 1;
+    ImageRegionIterator<TInputImage> it(image, image->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      it.Set(static_cast<typename TInputImage::PixelType>(seed >> 25));
+    }
+
+    typename HessianFilterType::Pointer hessianFilter = HessianFilterType::New();
+    hessianFilter->SetInput(image);
+    hessianFilter->SetMaximumError(m_MaximumError);
+    hessianFilter->SetMaximumKernelWidth(m_MaximumKernelWidth);
+    hessianFilter->SetNumberOfWorkUnits(m_NumberOfWorkUnits);
+
+    for (const RealType sigma : sigmas)
+    {
+      hessianFilter->SetSigma(sigma);
+      for (unsigned int i = 0; i < NumberOfBackends; ++i)
+      {
+        const auto backend = static_cast<ConvolutionBackendEnum>(i);
+        hessianFilter->SetConvolutionBackend(backend);
+        works[sample][i] = this->GetWork(backend, sigma, size, size, image->GetSpacing(), false);
+        times[sample][i] = Self::MeasureRunTime(hessianFilter);
+        itkDebugMacro(<< "Backend " << i << " took " << times[sample][i] << " s on " << size << " at sigma "
+                      << sigma);
+      }
+      ++sample;
+    }
+  }
+
+  /* Least squares line through the run times. Timing noise may give a negative slope or intercept, neither of
+   * which a run time can have, a line through the origin and the mean is used instead. */
+  for (unsigned int i = 0; i < NumberOfBackends; ++i)
+  {
+    double meanWork = 0.0;
+    double meanTime = 0.0;
+    for (sample = 0; sample < numberOfSamples; ++sample)
+    {
+      meanWork += works[sample][i] / numberOfSamples;
+      meanTime += times[sample][i] / numberOfSamples;
+    }
+    double covariance = 0.0;
+    double variance = 0.0;
+    for (sample = 0; sample < numberOfSamples; ++sample)
+    {
+      covariance += (works[sample][i] - meanWork) * (times[sample][i] - meanTime);
+      variance += (works[sample][i] - meanWork) * (works[sample][i] - meanWork);
+    }
+
+    double coefficient = variance > 0.0 ? covariance / variance : 0.0;
+    if (coefficient <= 0.0)
+    {
+      coefficient = meanTime / meanWork;
+    }
+    m_Coefficients[i] = coefficient;
+    m_Overheads[i] = std::max(meanTime - coefficient * meanWork, 0.0);
+  }
+
+  m_CalibratedNumberOfWorkUnits = m_NumberOfWorkUnits;
+  this->Modified();
+}
+
+template <typename TInputImage>
+double
+HessianGaussianCostModel<TInputImage>::MeasureRunTime(HessianFilterType * hessianFilter)
+{
+  /* Keep the fastest of a few runs to filter out the noise */
+  TimeProbe probe;
+  for (unsigned int run = 0; run < 3; ++run)
+  {
+    hessianFilter->ReleaseForwardTransform();
+    hessianFilter->Modified();
+    probe.Start();
+    hessianFilter->Update();
+    probe.Stop();
+  }
+  return probe.GetMinimum();
+}
+
+template <typename TInputImage>
+void
+HessianGaussianCostModel<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "CalibrationFileName: " << m_CalibrationFileName << std::endl;
+  os << indent << "NumberOfWorkUnits: " << m_NumberOfWorkUnits << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "MaximumKernelWidth: " << m_MaximumKernelWidth << std::endl;
+  os << indent << "CalibrationImageSize: " << m_CalibrationImageSize << std::endl;
+  os << indent << "CalibratedNumberOfWorkUnits: " << m_CalibratedNumberOfWorkUnits << std::endl;
+  os << indent << "Overheads:";
+  for (unsigned int i = 0; i < NumberOfBackends; ++i)
+  {
+    os << " " << m_Overheads[i];
+  }
+  os << std::endl;
+  os << indent << "Coefficients:";
+  for (unsigned int i = 0; i < NumberOfBackends; ++i)
+  {
+    os << " " << m_Coefficients[i];
+  }
+  os << std::endl;
+}
+
+} // end namespace itk
+
+#endif // itkHessianGaussianCostModel_hxx
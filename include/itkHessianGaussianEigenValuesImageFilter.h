@@ -0,0 +1,224 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkHessianGaussianEigenValuesImageFilter_h
+#define itkHessianGaussianEigenValuesImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkGaussianDerivativeOperator.h"
+#include "itkSymmetricEigenValuesImageFilter.h"
+#include "itkSymmetricSecondRankTensor.h"
+#include <vector>
+
+namespace itk
+{
+/** \class HessianGaussianEigenValuesImageFilter
+ * \brief Computes the eigenvalues of the Hessian of an image without storing the Hessian.
+ *
+ * This filter produces the output of HessianGaussianImageFilter with the
+ * discrete backend followed by SymmetricEigenValuesImageFilter, without the
+ * intermediate tensor image. The output requested region is split into tiles
+ * of TileSize pixels. For each tile, the input padded by the kernel radius is
+ * copied into a local buffer and the components of the Hessian are computed
+ * by the same tree of separable 1D passes as HessianGaussianImageFilter, on
+ * local buffers only. The eigenvalues of the tile are then solved while its
+ * components are still in cache. Tiles are processed in parallel.
+ *
+ * The input is extended by replicating its border pixels (zero flux Neumann
+ * boundary condition), as done by the discrete backend of
+ * HessianGaussianImageFilter. Sigma, InputSigma, NormalizeAcrossScale,
+ * MaximumError and MaximumKernelWidth have the same meaning as in
+ * HessianGaussianImageFilter.
+ *
+ * Smaller tiles fit better in cache but recompute a larger share of the
+ * passes in the padding around them. The default TileSize is 32 pixels per
+ * dimension in 3D and 256 in 2D.
+ *
+ * \sa HessianGaussianImageFilter
+ * \sa SymmetricEigenValuesImageFilter
+ * \sa MultiScaleHessianEnhancementImageFilter
+ *
+ * \ingroup BoneEnhancement
+ */
+template <typename TInputImage, typename TOutputImage>
+class ITK_TEMPLATE_EXPORT HessianGaussianEigenValuesImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(HessianGaussianEigenValuesImageFilter);
+
+  /** Standard Self typedef */
+  using Self = HessianGaussianEigenValuesImageFilter;
+  using Superclass = ImageToImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(HessianGaussianEigenValuesImageFilter, ImageToImageFilter);
+
+  /** Image dimension. */
+  itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+  /** Input image typedefs. */
+  using InputImageType = TInputImage;
+  using PixelType = typename TInputImage::PixelType;
+  using RealType = typename NumericTraits<PixelType>::RealType;
+  using SizeType = typename TInputImage::SizeType;
+  using InputImageRegionType = typename TInputImage::RegionType;
+
+  /** Output image typedefs. */
+  using OutputImageType = TOutputImage;
+  using OutputImagePixelType = typename OutputImageType::PixelType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using OutputValueType = typename OutputImagePixelType::ValueType;
+
+  /** Type of the passes, as in HessianGaussianImageFilter. */
+  using InternalRealType = float;
+  using OperatorType = GaussianDerivativeOperator<InternalRealType, ImageDimension>;
+
+  /** Derivative order along each dimension of a node in the pass tree */
+  using OrderArrayType = FixedArray<unsigned int, ImageDimension>;
+
+  /** Solver of the eigenvalues. */
+  using TensorImageType = Image<SymmetricSecondRankTensor<double, ImageDimension>, ImageDimension>;
+  using EigenSolverType = SymmetricEigenValuesImageFilter<TensorImageType, TOutputImage>;
+  using ComputeType = typename EigenSolverType::ComputeType;
+
+  /** Ordering of the eigenvalues. */
+  using EigenValueOrderEnum = typename EigenSolverType::EigenValueOrderEnum;
+
+  /** Set/Get Sigma, measured in the units of image spacing. Defaults to 1. */
+  itkSetMacro(Sigma, RealType);
+  itkGetConstMacro(Sigma, RealType);
+
+  /** Set/Get the standard deviation of the Gaussian blur the input already
+   * went through. \sa HessianGaussianImageFilter::SetInputSigma */
+  itkSetMacro(InputSigma, RealType);
+  itkGetConstMacro(InputSigma, RealType);
+
+  /** Define which normalization factor will be used for the Gaussian
+   * \sa HessianGaussianImageFilter::SetNormalizeAcrossScale */
+  itkSetMacro(NormalizeAcrossScale, bool);
+  itkGetConstMacro(NormalizeAcrossScale, bool);
+  itkBooleanMacro(NormalizeAcrossScale);
+
+  /** Set/Get the maximum error used to truncate the Gaussian kernels.
+   * \sa GaussianDerivativeOperator::SetMaximumError */
+  itkSetMacro(MaximumError, double);
+  itkGetConstMacro(MaximumError, double);
+
+  /** Set/Get the maximum width of the Gaussian kernels.
+   * \sa GaussianDerivativeOperator::SetMaximumKernelWidth */
+  itkSetMacro(MaximumKernelWidth, unsigned int);
+  itkGetConstMacro(MaximumKernelWidth, unsigned int);
+
+  /** Set/Get the ordering of the eigenvalues. Defaults to ordering by value. */
+  itkSetEnumMacro(EigenValueOrder, EigenValueOrderEnum);
+  itkGetEnumMacro(EigenValueOrder, EigenValueOrderEnum);
+
+  /** Set/Get the size of the tiles the output is computed by. */
+  itkSetMacro(TileSize, SizeType);
+  itkGetConstReferenceMacro(TileSize, SizeType);
+
+  /** The input requested region is the output requested region padded by
+   * the radius of the kernels. */
+  void
+  GenerateInputRequestedRegion() override;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro(InputHasNumericTraitsCheck, (Concept::HasNumericTraits<PixelType>));
+  itkConceptMacro(SameDimensionCheck,
+                  (Concept::SameDimension<TInputImage::ImageDimension, TOutputImage::ImageDimension>));
+  // End concept checking
+#endif
+
+protected:
+  HessianGaussianEigenValuesImageFilter();
+  ~HessianGaussianEigenValuesImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Create the 1D Gaussian derivative operator of the given order along a dimension.
+   * \sa HessianGaussianImageFilter::CreateOperator */
+  OperatorType
+  CreateOperator(unsigned int dimension, unsigned int order) const;
+
+  /** Standard deviation of the kernels, which accounts for InputSigma. */
+  RealType
+  GetKernelSigma() const;
+
+  /** Radius of the Gaussian kernels along each dimension. */
+  SizeType
+  GetKernelRadius() const;
+
+  /** Coefficients of a 1D kernel */
+  using KernelType = std::vector<InternalRealType>;
+
+  /** Local buffer of a tile, stored with the first dimension fastest */
+  using BufferType = std::vector<InternalRealType>;
+
+  /** Compute the eigenvalues of one tile of the output. */
+  void
+  GenerateTile(const OutputImageRegionType & tile);
+
+  /** Visit the node of the pass tree of a tile holding the buffer filtered
+   * along the dimensions before the given one with the derivative orders in order. */
+  void
+  GenerateDerivativesAlongDimension(const BufferType &      buffer,
+                                    const SizeType &        size,
+                                    unsigned int            dimension,
+                                    OrderArrayType &        order,
+                                    std::vector<BufferType> & components) const;
+
+  /** Convolve a buffer along a dimension, keeping only the pixels where the
+   * kernel fits in the buffer. */
+  static void
+  ConvolveAlongDimension(const BufferType & input,
+                         const SizeType &   inputSize,
+                         BufferType &       output,
+                         unsigned int       dimension,
+                         const KernelType & kernel);
+
+private:
+  RealType            m_Sigma;
+  RealType            m_InputSigma;
+  bool                m_NormalizeAcrossScale;
+  double              m_MaximumError;
+  unsigned int        m_MaximumKernelWidth;
+  EigenValueOrderEnum m_EigenValueOrder;
+  SizeType            m_TileSize;
+
+  /** Kernels of each order along each dimension, padded with zeros to the
+   * radius of their dimension, and that radius. Set up by GenerateData(). */
+  std::vector<KernelType> m_Kernels;
+  SizeType                m_KernelRadius;
+}; // end class
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkHessianGaussianEigenValuesImageFilter.hxx"
+#endif
+
+#endif // itkHessianGaussianEigenValuesImageFilter_h
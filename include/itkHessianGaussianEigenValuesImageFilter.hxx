@@ -0,0 +1,440 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkHessianGaussianEigenValuesImageFilter_hxx
+#define itkHessianGaussianEigenValuesImageFilter_hxx
+
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+template <typename TInputImage, typename TOutputImage>
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::HessianGaussianEigenValuesImageFilter()
+  : m_Sigma(1.0)
+  , m_InputSigma(0.0)
+  , m_NormalizeAcrossScale(false)
+  , m_MaximumError(0.01)
+  , m_MaximumKernelWidth(32)
+  , m_EigenValueOrder(EigenValueOrderEnum::OrderByValue)
+{
+  m_TileSize.Fill(ImageDimension == 2 ? 256 : 32);
+  m_KernelRadius.Fill(0);
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::RealType
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::GetKernelSigma() const
+{
+  if (m_InputSigma == 0.0)
+  {
+    return m_Sigma;
+  }
+
+  // Gaussians compose by adding their variances
+  if (m_InputSigma >= m_Sigma)
+  {
+    itkExceptionMacro(<< "InputSigma (" << m_InputSigma << ") must be smaller than Sigma (" << m_Sigma << ")");
+  }
+  return std::sqrt(m_Sigma * m_Sigma - m_InputSigma * m_InputSigma);
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::OperatorType
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::CreateOperator(unsigned int dimension,
+                                                                                 unsigned int order) const
+{
+  const double spacing = this->GetInput()->GetSpacing()[dimension];
+  if (spacing == 0.0)
+  {
+    itkExceptionMacro(<< "Pixel spacing cannot be zero");
+  }
+
+  // Same kernels as HessianGaussianImageFilter, the normalization across
+  // scale is applied on the last pass of each component
+  OperatorType oper;
+  oper.SetDirection(dimension);
+  oper.SetOrder(order);
+  oper.SetSpacing(spacing);
+  oper.SetNormalizeAcrossScale(false);
+  const RealType kernelSigma = this->GetKernelSigma();
+  oper.SetVariance(kernelSigma * kernelSigma);
+  oper.SetMaximumError(m_MaximumError);
+  oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+  oper.CreateDirectional();
+
+  return oper;
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::SizeType
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::GetKernelRadius() const
+{
+  SizeType radius;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    radius[i] = 0;
+    for (unsigned int order = 0; order <= 2; ++order)
+    {
+      radius[i] = std::max(radius[i], this->CreateOperator(i, order).GetRadius(i));
+    }
+  }
+  return radius;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  typename Superclass::InputImagePointer inputPtr = const_cast<TInputImage *>(this->GetInput());
+  if (!inputPtr)
+  {
+    return;
+  }
+
+  InputImageRegionType inputRequestedRegion = inputPtr->GetRequestedRegion();
+  inputRequestedRegion.PadByRadius(this->GetKernelRadius());
+
+  if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+  {
+    inputPtr->SetRequestedRegion(inputRequestedRegion);
+    return;
+  }
+
+  // The output requested region is outside the largest possible region
+  inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+  InvalidRequestedRegionError e(__FILE__, __LINE__);
+  e.SetLocation(ITK_LOCATION);
+  e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+  e.SetDataObject(inputPtr);
+  throw e;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  OutputImageType * outputPtr = this->GetOutput();
+
+  this->AllocateOutputs();
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    if (m_TileSize[i] == 0)
+    {
+      itkExceptionMacro(<< "TileSize must be positive, got " << m_TileSize);
+    }
+  }
+
+  // Kernels of each dimension are padded to the same radius so every node of
+  // the pass tree has the same size
+  m_KernelRadius = this->GetKernelRadius();
+  m_Kernels.assign(3 * ImageDimension, KernelType());
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int order = 0; order <= 2; ++order)
+    {
+      const OperatorType oper = this->CreateOperator(i, order);
+      const SizeValueType padding = m_KernelRadius[i] - oper.GetRadius(i);
+
+      KernelType & kernel = m_Kernels[3 * i + order];
+      kernel.assign(2 * m_KernelRadius[i] + 1, 0.0f);
+      std::copy(oper.Begin(), oper.End(), kernel.begin() + padding);
+    }
+  }
+
+  // Split the output requested region into tiles
+  const OutputImageRegionType &      requestedRegion = outputPtr->GetRequestedRegion();
+  std::vector<OutputImageRegionType> tiles;
+  SizeType                           numberOfTiles;
+  SizeValueType                      totalNumberOfTiles = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    numberOfTiles[i] = (requestedRegion.GetSize(i) + m_TileSize[i] - 1) / m_TileSize[i];
+    totalNumberOfTiles *= numberOfTiles[i];
+  }
+  tiles.reserve(totalNumberOfTiles);
+  for (SizeValueType t = 0; t < totalNumberOfTiles; ++t)
+  {
+    OutputImageRegionType tile;
+    SizeValueType         remainder = t;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const SizeValueType position = remainder % numberOfTiles[i];
+      remainder /= numberOfTiles[i];
+
+      const SizeValueType start = position * m_TileSize[i];
+      tile.SetIndex(i, requestedRegion.GetIndex(i) + static_cast<IndexValueType>(start));
+      tile.SetSize(i, std::min(m_TileSize[i], requestedRegion.GetSize(i) - start));
+    }
+    tiles.push_back(tile);
+  }
+
+  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
+  mt->ParallelizeArray(
+    0, totalNumberOfTiles, [this, &tiles](SizeValueType t) { this->GenerateTile(tiles[t]); }, this);
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::GenerateTile(const OutputImageRegionType & tile)
+{
+  const InputImageType *       inputPtr = this->GetInput();
+  OutputImageType *            outputPtr = this->GetOutput();
+  const InputImageRegionType & bufferedRegion = inputPtr->GetBufferedRegion();
+
+  // Copy the tile padded by the kernel radius, replicating the border pixels
+  // of the input outside of its buffered region
+  InputImageRegionType paddedRegion = tile;
+  paddedRegion.PadByRadius(m_KernelRadius);
+  const SizeType paddedSize = paddedRegion.GetSize();
+
+  using IndexType = typename InputImageType::IndexType;
+  const IndexType lowerIndex = bufferedRegion.GetIndex();
+  const IndexType upperIndex = bufferedRegion.GetUpperIndex();
+  IndexType       position = paddedRegion.GetIndex();
+  IndexType       clamped;
+  BufferType      padded(paddedRegion.GetNumberOfPixels());
+  for (auto & value : padded)
+  {
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      clamped[i] = std::min(std::max(position[i], lowerIndex[i]), upperIndex[i]);
+    }
+    value = static_cast<InternalRealType>(inputPtr->GetPixel(clamped));
+
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      if (++position[i] < paddedRegion.GetIndex(i) + static_cast<IndexValueType>(paddedSize[i]))
+      {
+        break;
+      }
+      position[i] = paddedRegion.GetIndex(i);
+    }
+  }
+
+  // Components of the tile, stored with the first dimension fastest
+  std::vector<BufferType> components(EigenSolverType::NumberOfComponents);
+  OrderArrayType          order;
+  order.Fill(0);
+  this->GenerateDerivativesAlongDimension(padded, paddedSize, 0, order, components);
+
+  // Solve the eigenvalues by batches while the components are in cache
+  constexpr unsigned int BatchSize = EigenSolverType::BatchSize;
+  ComputeType            batchComponents[EigenSolverType::NumberOfComponents][BatchSize];
+  ComputeType            eigenValues[ImageDimension][BatchSize];
+  const bool             orderByMagnitude = (m_EigenValueOrder == EigenValueOrderEnum::OrderByMagnitude);
+
+  ImageRegionIterator<OutputImageType> ot(outputPtr, tile);
+  const SizeValueType                  numberOfPixels = tile.GetNumberOfPixels();
+  for (SizeValueType start = 0; start < numberOfPixels; start += BatchSize)
+  {
+    const unsigned int n =
+      static_cast<unsigned int>(numberOfPixels - start < BatchSize ? numberOfPixels - start : BatchSize);
+    for (unsigned int c = 0; c < EigenSolverType::NumberOfComponents; ++c)
+    {
+      const InternalRealType * component = components[c].data() + start;
+      for (unsigned int k = 0; k < n; ++k)
+      {
+        batchComponents[c][k] = component[k];
+      }
+    }
+
+    EigenSolverType::ComputeBatch(batchComponents, eigenValues, n);
+
+    for (unsigned int k = 0; k < n; ++k, ++ot)
+    {
+      ComputeType values[ImageDimension];
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        values[i] = eigenValues[i][k];
+      }
+
+      if (orderByMagnitude)
+      {
+        EigenSolverType::SortByMagnitude(values);
+      }
+
+      OutputImagePixelType pixel;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        pixel[i] = static_cast<OutputValueType>(values[i]);
+      }
+      ot.Set(pixel);
+    }
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::GenerateDerivativesAlongDimension(
+  const BufferType &        buffer,
+  const SizeType &          size,
+  unsigned int              dimension,
+  OrderArrayType &          order,
+  std::vector<BufferType> & components) const
+{
+  // Derivative order left for this and the following dimensions
+  unsigned int remainingOrder = 2;
+  for (unsigned int k = 0; k < dimension; ++k)
+  {
+    remainingOrder -= order[k];
+  }
+
+  // The last dimension takes whatever order is left and produces a component
+  if (dimension == ImageDimension - 1)
+  {
+    order[dimension] = remainingOrder;
+
+    // Recover the two dimensions of differentiation from the orders
+    unsigned int dima = 0;
+    while (order[dima] == 0)
+    {
+      ++dima;
+    }
+    unsigned int dimb = dima;
+    if (order[dima] == 1)
+    {
+      ++dimb;
+      while (order[dimb] == 0)
+      {
+        ++dimb;
+      }
+    }
+
+    // Components are stored row by row in the upper triangle of the matrix
+    const unsigned int element = dima * ImageDimension - dima * (dima - 1) / 2 + (dimb - dima);
+
+    // Fold the normalization into the kernel, the operators differentiate in physical units already
+    double factor = 1.0;
+    if (m_NormalizeAcrossScale)
+    {
+      factor *= m_Sigma * m_Sigma;
+    }
+    KernelType kernel = m_Kernels[3 * dimension + remainingOrder];
+    for (auto & coefficient : kernel)
+    {
+      coefficient *= static_cast<InternalRealType>(factor);
+    }
+
+    Self::ConvolveAlongDimension(buffer, size, components[element], dimension, kernel);
+    order[dimension] = 0;
+    return;
+  }
+
+  SizeType passSize = size;
+  passSize[dimension] -= 2 * m_KernelRadius[dimension];
+
+  BufferType pass;
+  for (unsigned int thisOrder = 0; thisOrder <= remainingOrder; ++thisOrder)
+  {
+    order[dimension] = thisOrder;
+    Self::ConvolveAlongDimension(buffer, size, pass, dimension, m_Kernels[3 * dimension + thisOrder]);
+    this->GenerateDerivativesAlongDimension(pass, passSize, dimension + 1, order, components);
+  }
+  order[dimension] = 0;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::ConvolveAlongDimension(const BufferType & input,
+                                                                                        const SizeType &   inputSize,
+                                                                                        BufferType &       output,
+                                                                                        unsigned int       dimension,
+                                                                                        const KernelType & kernel)
+{
+  const SizeValueType radius = (kernel.size() - 1) / 2;
+  SizeType            outputSize = inputSize;
+  outputSize[dimension] -= 2 * radius;
+
+  SizeValueType inputStrides[ImageDimension];
+  SizeValueType outputStrides[ImageDimension];
+  inputStrides[0] = 1;
+  outputStrides[0] = 1;
+  SizeValueType numberOfLines = 1;
+  for (unsigned int i = 1; i < ImageDimension; ++i)
+  {
+    inputStrides[i] = inputStrides[i - 1] * inputSize[i - 1];
+    outputStrides[i] = outputStrides[i - 1] * outputSize[i - 1];
+    numberOfLines *= outputSize[i];
+  }
+  output.assign(outputStrides[ImageDimension - 1] * outputSize[ImageDimension - 1], 0.0f);
+
+  // Each line along the first dimension accumulates the shifted input lines
+  // weighted by the kernel, which the compiler vectorizes along the line
+  const SizeValueType lineLength = outputSize[0];
+  const SizeValueType tapStride = inputStrides[dimension];
+  SizeValueType       line[ImageDimension] = {};
+  for (SizeValueType l = 0; l < numberOfLines; ++l)
+  {
+    SizeValueType inputOffset = 0;
+    SizeValueType outputOffset = 0;
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      inputOffset += line[i] * inputStrides[i];
+      outputOffset += line[i] * outputStrides[i];
+    }
+
+    InternalRealType * out = output.data() + outputOffset;
+    for (SizeValueType t = 0; t < kernel.size(); ++t)
+    {
+      const InternalRealType weight = kernel[t];
+      if (weight == 0.0f)
+      {
+        continue;
+      }
+      const InternalRealType * in = input.data() + inputOffset + t * tapStride;
+      for (SizeValueType x = 0; x < lineLength; ++x)
+      {
+        out[x] += weight * in[x];
+      }
+    }
+
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      if (++line[i] < outputSize[i])
+      {
+        break;
+      }
+      line[i] = 0;
+    }
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianEigenValuesImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Sigma: " << m_Sigma << std::endl;
+  os << indent << "InputSigma: " << m_InputSigma << std::endl;
+  os << indent << "NormalizeAcrossScale: " << m_NormalizeAcrossScale << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "MaximumKernelWidth: " << m_MaximumKernelWidth << std::endl;
+  os << indent << "EigenValueOrder: " << static_cast<int>(m_EigenValueOrder) << std::endl;
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+}
+
+} // end namespace itk
+
+#endif // itkHessianGaussianEigenValuesImageFilter_hxx
@@ -19,11 +19,13 @@
 #ifndef itkHessianGaussianImageFilter_h
 #define itkHessianGaussianImageFilter_h
 
-#include "itkDiscreteGaussianDerivativeImageFilter.h"
-#include "itkNthElementImageAdaptor.h"
+#include "itkImageToImageFilter.h"
+#include "itkGaussianDerivativeOperator.h"
+#include "itkRecursiveGaussianImageFilter.h"
 #include "itkImage.h"
 #include "itkSymmetricSecondRankTensor.h"
 #include "itkPixelTraits.h"
+#include <complex>
 
 namespace itk
 {
@@ -32,15 +34,60 @@ namespace itk
  *        with the Second and Cross derivatives of a Gaussian
  *        with streaming.
  *
- * This filter is implemented using the discrete gaussian
+ * By default this filter is implemented using the discrete gaussian
  * filters to enable streaming. Although IIR filters are faster
  * than FIR filters, IIR filters cannot be streamed. FIR filters
  * are slower but can be streamed for small memory computers.
  *
+ * The backend used for the 1D passes is selected with SetConvolutionBackend().
+ * ConvolutionBackendEnum::Discrete convolves with truncated Gaussian kernels
+ * whose width grows linearly with sigma. ConvolutionBackendEnum::Recursive
+ * uses the recursive (Deriche) filters of RecursiveGaussianImageFilter whose
+ * cost per pixel does not depend on sigma, which pays off for large sigmas.
+ * The recursive passes need whole lines along every direction, so a
+ * restricted output requested region still requests the largest possible
+ * region of the input; only the passes along the later dimensions are
+ * restricted. ConvolutionBackendEnum::FFT computes the components in the
+ * frequency domain: one forward transform of the padded input, then for each
+ * component a pointwise multiplication by the analytic transfer function of
+ * the Gaussian derivative and an inverse transform. The forward transform is
+ * kept between updates and reused as long as the input and the padding do
+ * not change, so additional sigmas only cost the inverse transforms. Set
+ * PaddingSigma to the largest sigma to be computed on the same input so the
+ * padding does not change between scales. The FFT backend also requests the
+ * largest possible region of the input and transforms the whole padded volume
+ * whatever the output requested region is. All backends apply the same scale
+ * normalization.
+ *
  * This class is an exact copy of HessianRecursiveGaussianImageFilter
  * but with streaming.
  *
+ * The Gaussian derivatives are separable, so each component of the Hessian
+ * is computed as a sequence of 1D passes, one per dimension. Components that
+ * share the derivative orders of their first dimensions also share the
+ * corresponding passes. The passes are therefore planned as a tree: the
+ * first level holds the passes of order 0, 1 and 2 along x, the next level
+ * the passes along y applied to each of these, and so on. The leaves are the
+ * D(D+1)/2 components of the Hessian. In 3D this amounts to 15 passes instead
+ * of the 18 needed when each component is convolved independently. The tree
+ * is traversed depth first so at most one intermediate image per dimension
+ * is kept in memory.
+ *
+ * The last pass of each component writes straight into its element of the
+ * tensor output. The normalization across scale is folded into the kernel
+ * of that pass, so no full size temporary image is created for the
+ * components.
+ *
+ * All backends give the derivatives in physical units: the component (a, b)
+ * is the second derivative along the physical coordinates a and b, so the
+ * Hessian of the same image sampled on grids of different spacings has the
+ * same scale. Earlier versions divided the output of the discrete kernels,
+ * which differentiate in physical units already, by the spacings once more.
+ * On an image whose spacing is not one, the component (a, b) is now larger
+ * than it was by the product of the spacings along a and b.
+ *
  * \sa HessianRecursiveGaussianImageFilter.
+ * \sa RecursiveGaussianImageFilter
  *
  * \author: Bryce Besler
  * \ingroup BoneEnhancement
@@ -76,18 +123,25 @@ public:
   using InternalRealType = float;
   using RealImageType = Image<InternalRealType, TInputImage::ImageDimension>;
 
-  /**  Output Image Nth Element Adaptor
-   *  This adaptor allows to use conventional scalar
-   *  smoothing filters to compute each one of the
-   *  components of the gradient image pixels. */
-  using OutputImageAdaptorType = NthElementImageAdaptor<TOutputImage, InternalRealType>;
-  using OutputImageAdaptorPointer = typename OutputImageAdaptorType::Pointer;
+  /** Operator used for each 1D pass of the separable convolution */
+  using OperatorType = GaussianDerivativeOperator<InternalRealType, ImageDimension>;
 
-  /**  Derivative filter type */
-  using DerivativeFilterType = DiscreteGaussianDerivativeImageFilter<InputImageType, RealImageType>;
+  /** Frequency domain image used by the FFT backend */
+  using ComplexImageType = Image<std::complex<InternalRealType>, TInputImage::ImageDimension>;
 
-  /**  Pointer to a gaussian filter.  */
-  using DerivativeFilterPointer = typename DerivativeFilterType::Pointer;
+  /** Derivative order along each dimension of a node in the pass tree */
+  using OrderArrayType = FixedArray<unsigned int, ImageDimension>;
+
+  /**\class ConvolutionBackendEnum
+   * Method used to compute the 1D Gaussian derivative passes.
+   * \ingroup BoneEnhancement
+   */
+  enum class ConvolutionBackendEnum : uint8_t
+  {
+    Discrete = 0,
+    Recursive = 1,
+    FFT = 2
+  };
 
   /**  Pointer to the Output Image */
   using OutputImagePointer = typename TOutputImage::Pointer;
@@ -118,12 +172,55 @@ public:
   GetNormalizeAcrossScale() const;
   itkBooleanMacro(NormalizeAcrossScale);
 
+  /** Set/Get the maximum error used to truncate the Gaussian kernels.
+   * \sa GaussianDerivativeOperator::SetMaximumError */
+  itkSetMacro(MaximumError, double);
+  itkGetConstMacro(MaximumError, double);
+
+  /** Set/Get the maximum width of the Gaussian kernels.
+   * \sa GaussianDerivativeOperator::SetMaximumKernelWidth */
+  itkSetMacro(MaximumKernelWidth, unsigned int);
+  itkGetConstMacro(MaximumKernelWidth, unsigned int);
+
+  /** Set/Get the method used to compute the Gaussian derivatives. Defaults to
+   * ConvolutionBackendEnum::Discrete. */
+  itkSetEnumMacro(ConvolutionBackend, ConvolutionBackendEnum);
+  itkGetEnumMacro(ConvolutionBackend, ConvolutionBackendEnum);
+
+  /** Set/Get the standard deviation of the Gaussian blur the input already
+   * went through, measured in the units of image spacing. The kernels are
+   * narrowed to sqrt(Sigma^2 - InputSigma^2) so the output is the Hessian at
+   * Sigma of the image before that blur, and the normalization across scale
+   * uses Sigma. InputSigma must be smaller than Sigma. Defaults to zero. */
+  itkSetMacro(InputSigma, RealType);
+  itkGetConstMacro(InputSigma, RealType);
+
+  /** Set/Get the sigma used to size the padding of the FFT backend. The input
+   * is padded by four times the largest of the kernel sigma and PaddingSigma. When the
+   * filter is run for several sigmas on the same input, setting PaddingSigma
+   * to the largest of them lets every scale reuse the same forward transform.
+   * Defaults to zero. */
+  itkSetMacro(PaddingSigma, RealType);
+  itkGetConstMacro(PaddingSigma, RealType);
+
+  /** Release the forward transform kept by the FFT backend. */
+  void
+  ReleaseForwardTransform();
+
+  /** Whether the FFT backend holds a forward transform from a previous update. */
+  bool
+  HasForwardTransform() const;
+
+  /** Radius of the Gaussian kernels along each dimension, by which the
+   * discrete backend pads the input requested region. */
+  typename TInputImage::SizeType
+  GetKernelRadius() const;
+
   /** As opposed to HessianRecursiveGaussianImageFilter, HessianGaussianImageFilter
    * doe not need all of the input to produce an output. However, it does need to
    * expand the InputRequestedRegion region to account for the support of the
-   * Gaussian filter.
+   * Gaussian filter. The recursive backend requests the largest possible region.
    * \sa DiscreteGaussianDerivativeImageFilter::GenerateInputRequestedRegion() */
-  // TODO
   void
   GenerateInputRequestedRegion() override;
 
@@ -144,10 +241,74 @@ protected:
   void
   GenerateData() override;
 
+  /** Create the 1D Gaussian derivative operator of the given order along a dimension. */
+  OperatorType
+  CreateOperator(unsigned int dimension, unsigned int order) const;
+
+  /** Standard deviation of the kernels, which accounts for InputSigma. */
+  RealType
+  GetKernelSigma() const;
+
+  /** Region a pass along the given dimension has to produce so that the passes
+   * along the following dimensions can compute the output requested region. */
+  typename TInputImage::RegionType
+  GetPassRegion(unsigned int dimension) const;
+
+  /** Compute one pass of the tree along a dimension over the given region. */
+  template <typename TImage>
+  typename RealImageType::Pointer
+  ComputePass(const TImage *                           image,
+              unsigned int                             dimension,
+              unsigned int                             order,
+              const typename TInputImage::RegionType & region);
+
+  /** Scale factor of a component which is not folded into the kernels. */
+  InternalRealType
+  GetComponentFactor(unsigned int dima, unsigned int dimb) const;
+
+  /** Visit the node of the pass tree holding the image filtered along the
+   * dimensions before the given one with the derivative orders in order. */
+  template <typename TImage>
+  void
+  GenerateDerivativesAlongDimension(const TImage * image, unsigned int dimension, OrderArrayType & order);
+
+  /** Compute the last pass of a component directly into its element of the output. */
+  template <typename TImage>
+  void
+  GenerateComponent(const TImage * image, const OrderArrayType & order);
+
+  /** Compute all the components in the frequency domain. */
+  void
+  GenerateDataUsingFFT();
+
+  /** Padding of the input used by the FFT backend along each dimension. */
+  typename TInputImage::SizeType
+  GetFFTPadding() const;
+
 private:
-  /** Internal filters **/
-  DerivativeFilterPointer   m_DerivativeFilter;
-  OutputImageAdaptorPointer m_ImageAdaptor;
+  /** Report the progress after one more pass of the tree was computed. */
+  void
+  CompletePass();
+
+  RealType               m_Sigma;
+  bool                   m_NormalizeAcrossScale;
+  double                 m_MaximumError;
+  unsigned int           m_MaximumKernelWidth;
+  ConvolutionBackendEnum m_ConvolutionBackend;
+  RealType               m_InputSigma;
+  RealType               m_PaddingSigma;
+
+  /** Forward transform of the padded input kept by the FFT backend, together
+   * with what it was computed from. */
+  typename ComplexImageType::Pointer m_ForwardTransform;
+  typename TInputImage::RegionType   m_ForwardTransformPaddedRegion;
+  typename TInputImage::SizeType     m_ForwardTransformPadding;
+  const TInputImage *                m_ForwardTransformInput;
+  ModifiedTimeType                   m_ForwardTransformInputTime;
+
+  /** Progress through the pass tree */
+  unsigned int m_NumberOfPasses;
+  unsigned int m_NumberOfCompletedPasses;
 }; // end class
 } // namespace itk
 
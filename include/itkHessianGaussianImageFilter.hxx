@@ -19,9 +19,17 @@
 #ifndef itkHessianGaussianImageFilter_hxx
 #define itkHessianGaussianImageFilter_hxx
 
-#include "itkImageRegionIteratorWithIndex.h"
-#include "itkProgressAccumulator.h"
-#include "itkGaussianDerivativeOperator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkNeighborhoodOperatorImageFilter.h"
+#include "itkNeighborhoodAlgorithm.h"
+#include "itkNeighborhoodInnerProduct.h"
+#include "itkConstNeighborhoodIterator.h"
+#include "itkZeroFluxNeumannPadImageFilter.h"
+#include "itkFFTPadImageFilter.h"
+#include "itkRealToHalfHermitianForwardFFTImageFilter.h"
+#include "itkHalfHermitianToRealInverseFFTImageFilter.h"
 #include "itkMath.h"
 
 namespace itk
@@ -31,19 +39,19 @@ namespace itk
  */
 template <typename TInputImage, typename TOutputImage>
 HessianGaussianImageFilter<TInputImage, TOutputImage>::HessianGaussianImageFilter()
+  : m_Sigma(1.0)
+  , m_NormalizeAcrossScale(false)
+  , m_MaximumError(0.01)
+  , m_MaximumKernelWidth(32)
+  , m_ConvolutionBackend(ConvolutionBackendEnum::Discrete)
+  , m_InputSigma(0.0)
+  , m_PaddingSigma(0.0)
+  , m_ForwardTransformInput(nullptr)
+  , m_ForwardTransformInputTime(0)
+  , m_NumberOfPasses(0)
+  , m_NumberOfCompletedPasses(0)
 {
-  // Create Derivative Filter
-  m_DerivativeFilter = DerivativeFilterType::New();
-  m_DerivativeFilter->SetInput(this->GetInput());
-  m_DerivativeFilter->ReleaseDataFlagOn(); // output is only used once
-  m_DerivativeFilter->UseImageSpacingOn();
-
-  // Create image adaptor
-  m_ImageAdaptor = OutputImageAdaptorType::New();
-
-  // Setup defaults
-  this->SetNormalizeAcrossScale(false);
-  this->SetSigma(1.0);
+  m_ForwardTransformPadding.Fill(0);
 }
 
 /**
@@ -53,7 +61,7 @@ template <typename TInputImage, typename TOutputImage>
 void
 HessianGaussianImageFilter<TInputImage, TOutputImage>::SetSigma(RealType sigma)
 {
-  m_DerivativeFilter->SetVariance(sigma * sigma);
+  m_Sigma = sigma;
 
   this->Modified();
 }
@@ -65,7 +73,7 @@ template <typename TInputImage, typename TOutputImage>
 typename HessianGaussianImageFilter<TInputImage, TOutputImage>::RealType
 HessianGaussianImageFilter<TInputImage, TOutputImage>::GetSigma() const
 {
-  return sqrt(m_DerivativeFilter->GetVariance()[0]);
+  return m_Sigma;
 }
 
 /**
@@ -75,7 +83,7 @@ template <typename TInputImage, typename TOutputImage>
 void
 HessianGaussianImageFilter<TInputImage, TOutputImage>::SetNormalizeAcrossScale(bool normalize)
 {
-  m_DerivativeFilter->SetNormalizeAcrossScale(normalize);
+  m_NormalizeAcrossScale = normalize;
 
   this->Modified();
 }
@@ -87,53 +95,129 @@ template <typename TInputImage, typename TOutputImage>
 bool
 HessianGaussianImageFilter<TInputImage, TOutputImage>::GetNormalizeAcrossScale() const
 {
-  return m_DerivativeFilter->GetNormalizeAcrossScale();
+  return m_NormalizeAcrossScale;
 }
 
 template <typename TInputImage, typename TOutputImage>
-void
-HessianGaussianImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+typename HessianGaussianImageFilter<TInputImage, TOutputImage>::RealType
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GetKernelSigma() const
 {
-  // call the superclass' implementation of this method. this should
-  // copy the output requested region to the input requested region
-  Superclass::GenerateInputRequestedRegion();
+  if (m_InputSigma == 0.0)
+  {
+    return m_Sigma;
+  }
 
-  // get pointers to the input
-  typename Superclass::InputImagePointer inputPtr = const_cast<TInputImage *>(this->GetInput());
+  // Gaussians compose by adding their variances
+  if (m_InputSigma >= m_Sigma)
+  {
+    itkExceptionMacro(<< "InputSigma (" << m_InputSigma << ") must be smaller than Sigma (" << m_Sigma << ")");
+  }
+  return std::sqrt(m_Sigma * m_Sigma - m_InputSigma * m_InputSigma);
+}
 
-  if (!inputPtr)
+template <typename TInputImage, typename TOutputImage>
+typename HessianGaussianImageFilter<TInputImage, TOutputImage>::OperatorType
+HessianGaussianImageFilter<TInputImage, TOutputImage>::CreateOperator(unsigned int dimension,
+                                                                      unsigned int order) const
+{
+  const double spacing = this->GetInput()->GetSpacing()[dimension];
+  if (spacing == 0.0)
   {
-    return;
+    itkExceptionMacro(<< "Pixel spacing cannot be zero");
   }
 
-  // Build an operator so that we can determine the kernel size
-  GaussianDerivativeOperator<InternalRealType, ImageDimension> oper;
-  typename TInputImage::SizeType                               radius;
+  // GaussianDerivativeOperator modifies the variance when setting image
+  // spacing. The normalization across scale is applied on the last pass of
+  // each component, see GetComponentFactor().
+  OperatorType oper;
+  oper.SetDirection(dimension);
+  oper.SetOrder(order);
+  oper.SetSpacing(spacing);
+  oper.SetNormalizeAcrossScale(false);
+  const RealType kernelSigma = this->GetKernelSigma();
+  oper.SetVariance(kernelSigma * kernelSigma);
+  oper.SetMaximumError(m_MaximumError);
+  oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+  oper.CreateDirectional();
+
+  return oper;
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename TInputImage::SizeType
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GetKernelRadius() const
+{
+  typename TInputImage::SizeType radius;
 
-  for (unsigned int i = 0; i < TInputImage::ImageDimension; i++)
+  for (unsigned int i = 0; i < ImageDimension; ++i)
   {
     // Determine the size of the operator in this dimension.  Note that the
     // Gaussian is built as a 1D operator in each of the specified directions.
-    oper.SetDirection(i);
-    if (this->GetInput()->GetSpacing()[i] == 0.0)
+    radius[i] = 0;
+    for (unsigned int order = 0; order <= 2; ++order)
     {
-      itkExceptionMacro(<< "Pixel spacing cannot be zero");
+      radius[i] = std::max(radius[i], this->CreateOperator(i, order).GetRadius(i));
     }
-    else
+  }
+
+  return radius;
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename TInputImage::RegionType
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GetPassRegion(unsigned int dimension) const
+{
+  const typename TInputImage::RegionType & largestRegion = this->GetInput()->GetLargestPossibleRegion();
+  typename TInputImage::RegionType         region = this->GetOutput()->GetRequestedRegion();
+
+  if (m_ConvolutionBackend == ConvolutionBackendEnum::Recursive)
+  {
+    // Recursive passes need whole lines along the following dimensions
+    for (unsigned int i = dimension + 1; i < ImageDimension; ++i)
     {
-      oper.SetSpacing(this->GetInput()->GetSpacing()[i]);
+      region.SetIndex(i, largestRegion.GetIndex(i));
+      region.SetSize(i, largestRegion.GetSize(i));
     }
+    return region;
+  }
 
-    // GaussianDerivativeOperator modifies the variance when setting image
-    // spacing
-    oper.SetVariance(this->m_DerivativeFilter->GetVariance()[i]);
-    oper.SetMaximumError(this->m_DerivativeFilter->GetMaximumError()[i]);
-    oper.SetMaximumKernelWidth(this->m_DerivativeFilter->GetMaximumKernelWidth());
-    oper.CreateDirectional();
+  typename TInputImage::SizeType radius = this->GetKernelRadius();
+  for (unsigned int i = 0; i <= dimension; ++i)
+  {
+    radius[i] = 0;
+  }
+
+  region.PadByRadius(radius);
+  region.Crop(largestRegion);
+
+  return region;
+}
 
-    radius[i] = oper.GetRadius(i);
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method. this should
+  // copy the output requested region to the input requested region
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the input
+  typename Superclass::InputImagePointer inputPtr = const_cast<TInputImage *>(this->GetInput());
+
+  if (!inputPtr)
+  {
+    return;
+  }
+
+  if (m_ConvolutionBackend == ConvolutionBackendEnum::Recursive || m_ConvolutionBackend == ConvolutionBackendEnum::FFT)
+  {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+    return;
   }
 
+  // Build the operators so that we can determine the kernel size
+  const typename TInputImage::SizeType radius = this->GetKernelRadius();
+
   // get a copy of the input requested region (should equal the output
   // requested region)
   typename TInputImage::RegionType inputRequestedRegion;
@@ -174,92 +258,458 @@ HessianGaussianImageFilter<TInputImage, TOutputImage>::GenerateData()
 {
   itkDebugMacro(<< "HessianGaussianImageFilter generating data ");
 
-  // Create a process accumulator for tracking the progress of this
-  // minipipeline
-  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
-  progress = ProgressAccumulator::New();
-  progress->SetMiniPipelineFilter(this);
+  const typename TInputImage::ConstPointer inputImage(this->GetInput());
 
-  // Compute the contribution of each filter to the total progress.
-  // For a DxD matrix, we do the following number of computations:
-  //    \sum_{i=1}^D \sum_{j=i}^D 1 = D(D+1)/2
-  const double weight = 1.0 / (ImageDimension * (ImageDimension + 1) / 2.0);
+  // The components are written directly into the output
+  this->AllocateOutputs();
 
-  progress->RegisterInternalFilter(m_DerivativeFilter, weight);
+  if (m_ConvolutionBackend == ConvolutionBackendEnum::FFT)
+  {
+    this->GenerateDataUsingFFT();
+    return;
+  }
 
-  const typename TInputImage::ConstPointer inputImage(this->GetInput());
+  // Count the passes of the tree for progress reporting. A node at depth
+  // d < D-1 is a choice of orders for the first d+1 dimensions summing to at
+  // most two, that is (d+3)(d+2)/2 nodes. The last level holds the D(D+1)/2
+  // components of the Hessian.
+  m_NumberOfPasses = ImageDimension * (ImageDimension + 1) / 2;
+  for (unsigned int d = 0; d + 1 < ImageDimension; ++d)
+  {
+    m_NumberOfPasses += (d + 3) * (d + 2) / 2;
+  }
+  m_NumberOfCompletedPasses = 0;
 
-  // Setup Image Adaptor
-  m_ImageAdaptor->SetImage(this->GetOutput());
+  OrderArrayType order;
+  order.Fill(0);
+  this->GenerateDerivativesAlongDimension(inputImage.GetPointer(), 0, order);
+}
 
-  m_ImageAdaptor->SetLargestPossibleRegion(this->GetOutput()->GetLargestPossibleRegion());
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage>
+typename HessianGaussianImageFilter<TInputImage, TOutputImage>::RealImageType::Pointer
+HessianGaussianImageFilter<TInputImage, TOutputImage>::ComputePass(const TImage *                           image,
+                                                                   unsigned int                             dimension,
+                                                                   unsigned int                             order,
+                                                                   const typename TInputImage::RegionType & region)
+{
+  typename RealImageType::Pointer passImage;
 
-  m_ImageAdaptor->SetBufferedRegion(this->GetOutput()->GetRequestedRegion());
+  switch (m_ConvolutionBackend)
+  {
+    case ConvolutionBackendEnum::Discrete:
+    {
+      using PassFilterType = NeighborhoodOperatorImageFilter<TImage, RealImageType, InternalRealType>;
+      typename PassFilterType::Pointer passFilter = PassFilterType::New();
+      passFilter->SetOperator(this->CreateOperator(dimension, order));
+      passFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+      passFilter->SetInput(image);
+      passFilter->GetOutput()->SetRequestedRegion(region);
+      passFilter->Update();
+      passImage = passFilter->GetOutput();
+      break;
+    }
+    case ConvolutionBackendEnum::Recursive:
+    {
+      // Normalization across scale is applied on the last pass of each component
+      using PassFilterType = RecursiveGaussianImageFilter<TImage, RealImageType>;
+      typename PassFilterType::Pointer passFilter = PassFilterType::New();
+      passFilter->SetDirection(dimension);
+      passFilter->SetSigma(this->GetKernelSigma());
+      passFilter->SetNormalizeAcrossScale(false);
+      switch (order)
+      {
+        case 0:
+          passFilter->SetZeroOrder();
+          break;
+        case 1:
+          passFilter->SetFirstOrder();
+          break;
+        default:
+          passFilter->SetSecondOrder();
+          break;
+      }
+      passFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+      passFilter->SetInput(image);
+      passFilter->GetOutput()->SetRequestedRegion(region);
+      passFilter->Update();
+      passImage = passFilter->GetOutput();
+      break;
+    }
+    default:
+      itkExceptionMacro(<< "Unknown convolution backend " << static_cast<int>(m_ConvolutionBackend));
+  }
 
-  m_ImageAdaptor->SetRequestedRegion(this->GetOutput()->GetRequestedRegion());
+  passImage->DisconnectPipeline();
+  return passImage;
+}
 
-  m_ImageAdaptor->Allocate();
+template <typename TInputImage, typename TOutputImage>
+typename HessianGaussianImageFilter<TInputImage, TOutputImage>::InternalRealType
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GetComponentFactor(unsigned int dima, unsigned int dimb) const
+{
+  // GaussianDerivativeOperator and the transfer functions of the FFT backend
+  // differentiate in physical units already. The recursive filters
+  // differentiate per pixel, so their derivatives are divided by the spacings
+  // as in HessianRecursiveGaussianImageFilter.
+  double factor = 1.0;
+  if (m_ConvolutionBackend == ConvolutionBackendEnum::Recursive)
+  {
+    factor /= this->GetInput()->GetSpacing()[dima] * this->GetInput()->GetSpacing()[dimb];
+  }
 
-  m_DerivativeFilter->SetInput(inputImage);
-  m_DerivativeFilter->GetOutput()->SetRequestedRegion(this->GetOutput()->GetRequestedRegion());
+  // Scale-space normalization of a second order derivative
+  if (m_NormalizeAcrossScale)
+  {
+    factor *= m_Sigma * m_Sigma;
+  }
 
-  unsigned int element = 0;
-  int          order[ImageDimension];
+  return static_cast<InternalRealType>(factor);
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage>
+void
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GenerateDerivativesAlongDimension(const TImage * image,
+                                                                                         unsigned int   dimension,
+                                                                                         OrderArrayType & order)
+{
+  // Derivative order left for this and the following dimensions
+  unsigned int remainingOrder = 2;
+  for (unsigned int k = 0; k < dimension; ++k)
+  {
+    remainingOrder -= order[k];
+  }
+
+  // The last dimension takes whatever order is left and produces a component
+  if (dimension == ImageDimension - 1)
+  {
+    order[dimension] = remainingOrder;
+    this->GenerateComponent(image, order);
+    order[dimension] = 0;
+    return;
+  }
+
+  for (unsigned int thisOrder = 0; thisOrder <= remainingOrder; ++thisOrder)
+  {
+    order[dimension] = thisOrder;
+
+    typename RealImageType::Pointer passImage =
+      this->ComputePass(image, dimension, thisOrder, this->GetPassRegion(dimension));
+    this->CompletePass();
+
+    // Descend into the subtree sharing this pass
+    this->GenerateDerivativesAlongDimension(passImage.GetPointer(), dimension + 1, order);
+  }
+  order[dimension] = 0;
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage>
+void
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GenerateComponent(const TImage *         image,
+                                                                         const OrderArrayType & order)
+{
+  const unsigned int dimension = ImageDimension - 1;
 
-  for (unsigned int dima = 0; dima < ImageDimension; dima++)
+  // Recover the two dimensions of differentiation from the orders
+  unsigned int dima = 0;
+  while (order[dima] == 0)
+  {
+    ++dima;
+  }
+  unsigned int dimb = dima;
+  if (order[dima] == 1)
   {
-    for (unsigned int dimb = dima; dimb < ImageDimension; dimb++)
+    ++dimb;
+    while (order[dimb] == 0)
     {
-      // All directions have zero order derivative initially
-      for (unsigned int k = 0; k < ImageDimension; ++k)
-      {
-        order[k] = 0;
-      }
+      ++dimb;
+    }
+  }
+
+  // Components are stored row by row in the upper triangle of the matrix
+  const unsigned int element = dima * ImageDimension - dima * (dima - 1) / 2 + (dimb - dima);
 
-      // Now set derivative directions. Note that this takes care
-      // of the case when dima == dimb
-      order[dima] = order[dima] + 1;
-      order[dimb] = order[dimb] + 1;
+  const InternalRealType factor = this->GetComponentFactor(dima, dimb);
 
-      // Set order and update
-      m_DerivativeFilter->SetOrder(order);
-      m_DerivativeFilter->Update();
-      typename RealImageType::Pointer derivativeImage;
-      derivativeImage = m_DerivativeFilter->GetOutput();
+  OutputImageType * outputPtr = this->GetOutput();
 
-      // Copy the results to the corresponding component
-      // on the output image of vectors
-      m_ImageAdaptor->SelectNthElement(element++);
+  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
+
+  if (m_ConvolutionBackend == ConvolutionBackendEnum::Recursive)
+  {
+    // The recursive filters cannot write into the tensor, copy their result
+    typename RealImageType::Pointer derivativeImage =
+      this->ComputePass(image, dimension, order[dimension], outputPtr->GetRequestedRegion());
+
+    mt->ParallelizeImageRegion<ImageDimension>(
+      outputPtr->GetRequestedRegion(),
+      [&derivativeImage, outputPtr, element, factor](const typename OutputImageType::RegionType & region) {
+        ImageRegionConstIterator<RealImageType> it(derivativeImage, region);
+        ImageRegionIterator<OutputImageType>    ot(outputPtr, region);
+        while (!it.IsAtEnd())
+        {
+          ot.Value()[element] = static_cast<OutputComponentType>(it.Get() * factor);
+          ++it;
+          ++ot;
+        }
+      },
+      nullptr);
+
+    this->CompletePass();
+    return;
+  }
 
-      ImageRegionIteratorWithIndex<RealImageType> it(derivativeImage, derivativeImage->GetRequestedRegion());
+  // Fold the normalization of the component into the kernel of the last pass
+  OperatorType oper = this->CreateOperator(dimension, order[dimension]);
+  for (unsigned int i = 0; i < oper.Size(); ++i)
+  {
+    oper[i] *= factor;
+  }
 
-      ImageRegionIteratorWithIndex<OutputImageAdaptorType> ot(m_ImageAdaptor, m_ImageAdaptor->GetRequestedRegion());
+  using BoundaryConditionType = ZeroFluxNeumannBoundaryCondition<TImage>;
+  using FaceCalculatorType = NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<TImage>;
+  using NeighborhoodIteratorType = ConstNeighborhoodIterator<TImage, BoundaryConditionType>;
+  using InnerProductType = NeighborhoodInnerProduct<TImage, InternalRealType, InternalRealType>;
 
-      const RealType spacingA = inputImage->GetSpacing()[dima];
-      const RealType spacingB = inputImage->GetSpacing()[dimb];
+  mt->ParallelizeImageRegion<ImageDimension>(
+    outputPtr->GetRequestedRegion(),
+    [image, outputPtr, element, &oper](const typename OutputImageType::RegionType & region) {
+      FaceCalculatorType faceCalculator;
+      InnerProductType   innerProduct;
 
-      const RealType factor = spacingA * spacingB;
+      // Only the faces touching the boundary of the buffer need the boundary condition
+      const typename FaceCalculatorType::FaceListType faceList = faceCalculator(image, region, oper.GetRadius());
 
-      it.GoToBegin();
-      ot.GoToBegin();
-      while (!it.IsAtEnd())
+      for (const auto & face : faceList)
       {
-        ot.Set(it.Get() / factor);
-        ++it;
-        ++ot;
+        NeighborhoodIteratorType             nit(oper.GetRadius(), image, face);
+        ImageRegionIterator<OutputImageType> ot(outputPtr, face);
+
+        nit.GoToBegin();
+        ot.GoToBegin();
+        while (!nit.IsAtEnd())
+        {
+          ot.Value()[element] = static_cast<OutputComponentType>(innerProduct(nit, oper));
+          ++nit;
+          ++ot;
+        }
       }
+    },
+    nullptr);
+
+  this->CompletePass();
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename TInputImage::SizeType
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GetFFTPadding() const
+{
+  const typename TInputImage::SpacingType & spacing = this->GetInput()->GetSpacing();
+  const RealType                            sigma = std::max(this->GetKernelSigma(), m_PaddingSigma);
+
+  // The padding keeps the circular convolution from wrapping one side of the
+  // image onto the other. The Gaussian is negligible beyond four sigmas.
+  typename TInputImage::SizeType padding;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    if (spacing[i] == 0.0)
+    {
+      itkExceptionMacro(<< "Pixel spacing cannot be zero");
+    }
+    padding[i] = static_cast<SizeValueType>(std::ceil(4.0 * sigma / spacing[i]));
+  }
+
+  return padding;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianImageFilter<TInputImage, TOutputImage>::GenerateDataUsingFFT()
+{
+  const TInputImage * inputPtr = this->GetInput();
+  OutputImageType *   outputPtr = this->GetOutput();
+
+  // One forward transform, then one inverse transform per component
+  m_NumberOfPasses = ImageDimension * (ImageDimension + 1) / 2 + 1;
+  m_NumberOfCompletedPasses = 0;
+
+  const typename TInputImage::SizeType padding = this->GetFFTPadding();
+  const ModifiedTimeType               inputTime = std::max(inputPtr->GetMTime(), inputPtr->GetUpdateMTime());
+
+  if (m_ForwardTransform.IsNull() || m_ForwardTransformInput != inputPtr || m_ForwardTransformInputTime != inputTime ||
+      m_ForwardTransformPadding != padding)
+  {
+    using PadFilterType = ZeroFluxNeumannPadImageFilter<TInputImage, RealImageType>;
+    typename PadFilterType::Pointer padFilter = PadFilterType::New();
+    padFilter->SetInput(inputPtr);
+    padFilter->SetPadLowerBound(padding);
+    padFilter->SetPadUpperBound(padding);
+    padFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+    // Grow the padded image to sizes the FFT implementation supports
+    using FFTPadFilterType = FFTPadImageFilter<RealImageType>;
+    typename FFTPadFilterType::Pointer fftPadFilter = FFTPadFilterType::New();
+    fftPadFilter->SetInput(padFilter->GetOutput());
+    fftPadFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+    using ForwardFFTFilterType = RealToHalfHermitianForwardFFTImageFilter<RealImageType, ComplexImageType>;
+    typename ForwardFFTFilterType::Pointer forwardFilter = ForwardFFTFilterType::New();
+    forwardFilter->SetInput(fftPadFilter->GetOutput());
+    forwardFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    forwardFilter->Update();
+
+    m_ForwardTransformPaddedRegion = fftPadFilter->GetOutput()->GetLargestPossibleRegion();
+    m_ForwardTransform = forwardFilter->GetOutput();
+    m_ForwardTransform->DisconnectPipeline();
+    m_ForwardTransformPadding = padding;
+    m_ForwardTransformInput = inputPtr;
+    m_ForwardTransformInputTime = inputTime;
+  }
+  this->CompletePass();
+
+  const ComplexImageType *                      forwardTransform = m_ForwardTransform.GetPointer();
+  const typename ComplexImageType::RegionType & frequencyRegion = forwardTransform->GetLargestPossibleRegion();
+  const typename TInputImage::SizeType &        paddedSize = m_ForwardTransformPaddedRegion.GetSize();
+  const typename TInputImage::SpacingType &     spacing = inputPtr->GetSpacing();
+  const double                                  kernelSigma = this->GetKernelSigma();
+
+  // Angular frequency and Gaussian transfer function along each dimension.
+  // Indices past the middle hold the negative frequencies, except along the
+  // first dimension where only the non-negative half of the spectrum is stored.
+  // The first derivative is odd, so its transfer function is zero at the
+  // Nyquist frequency of an even size, which is its own negative.
+  std::vector<std::vector<double>> frequencies(ImageDimension);
+  std::vector<std::vector<double>> oddFrequencies(ImageDimension);
+  std::vector<std::vector<double>> gaussians(ImageDimension);
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const SizeValueType size = frequencyRegion.GetSize(i);
+    frequencies[i].resize(size);
+    oddFrequencies[i].resize(size);
+    gaussians[i].resize(size);
+    for (SizeValueType k = 0; k < size; ++k)
+    {
+      const double frequency =
+        (i == 0 || 2 * k <= paddedSize[i]) ? static_cast<double>(k) : static_cast<double>(k) - paddedSize[i];
+      const double omega = 2.0 * Math::pi * frequency / (paddedSize[i] * spacing[i]);
+      frequencies[i][k] = omega;
+      oddFrequencies[i][k] = 2 * k == paddedSize[i] ? 0.0 : omega;
+      gaussians[i][k] = std::exp(-0.5 * kernelSigma * kernelSigma * omega * omega);
+    }
+  }
 
-      derivativeImage->ReleaseData();
+  typename ComplexImageType::Pointer productImage = ComplexImageType::New();
+  productImage->CopyInformation(forwardTransform);
+  productImage->SetRegions(frequencyRegion);
+  productImage->Allocate();
+
+  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
+
+  unsigned int element = 0;
+  for (unsigned int dima = 0; dima < ImageDimension; ++dima)
+  {
+    for (unsigned int dimb = dima; dimb < ImageDimension; ++dimb, ++element)
+    {
+      // The transfer function of the derivative along a and b is
+      // (j w_a)(j w_b) = -w_a w_b times the Gaussian
+      const double factor = -this->GetComponentFactor(dima, dimb);
+      const std::vector<std::vector<double>> & componentFrequencies = dima == dimb ? frequencies : oddFrequencies;
+
+      mt->ParallelizeImageRegion<ImageDimension>(
+        frequencyRegion,
+        [forwardTransform, &productImage, &componentFrequencies, &gaussians, &frequencyRegion, dima, dimb, factor](
+          const typename ComplexImageType::RegionType & region) {
+          ImageRegionConstIteratorWithIndex<ComplexImageType> it(forwardTransform, region);
+          ImageRegionIterator<ComplexImageType>               ot(productImage, region);
+          while (!it.IsAtEnd())
+          {
+            const typename ComplexImageType::IndexType index = it.GetIndex();
+
+            double transfer = factor * componentFrequencies[dima][index[dima] - frequencyRegion.GetIndex(dima)] *
+                              componentFrequencies[dimb][index[dimb] - frequencyRegion.GetIndex(dimb)];
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              transfer *= gaussians[i][index[i] - frequencyRegion.GetIndex(i)];
+            }
+
+            ot.Set(it.Get() * static_cast<InternalRealType>(transfer));
+            ++it;
+            ++ot;
+          }
+        },
+        nullptr);
+
+      using InverseFFTFilterType = HalfHermitianToRealInverseFFTImageFilter<ComplexImageType, RealImageType>;
+      typename InverseFFTFilterType::Pointer inverseFilter = InverseFFTFilterType::New();
+      inverseFilter->SetInput(productImage);
+      inverseFilter->SetActualXDimensionIsOdd(paddedSize[0] % 2 != 0);
+      inverseFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+      inverseFilter->Update();
+
+      // Locate the output in the index space of the padded image
+      const RealImageType *                    derivativeImage = inverseFilter->GetOutput();
+      const typename RealImageType::OffsetType offset =
+        derivativeImage->GetLargestPossibleRegion().GetIndex() - m_ForwardTransformPaddedRegion.GetIndex();
+
+      mt->ParallelizeImageRegion<ImageDimension>(
+        outputPtr->GetRequestedRegion(),
+        [derivativeImage, outputPtr, element, &offset](const typename OutputImageType::RegionType & region) {
+          typename RealImageType::RegionType derivativeRegion = region;
+          derivativeRegion.SetIndex(region.GetIndex() + offset);
+
+          ImageRegionConstIterator<RealImageType> it(derivativeImage, derivativeRegion);
+          ImageRegionIterator<OutputImageType>    ot(outputPtr, region);
+          while (!it.IsAtEnd())
+          {
+            ot.Value()[element] = static_cast<OutputComponentType>(it.Get());
+            ++it;
+            ++ot;
+          }
+        },
+        nullptr);
+
+      this->CompletePass();
     }
   }
 }
 
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianImageFilter<TInputImage, TOutputImage>::ReleaseForwardTransform()
+{
+  m_ForwardTransform = nullptr;
+  m_ForwardTransformInput = nullptr;
+}
+
+template <typename TInputImage, typename TOutputImage>
+bool
+HessianGaussianImageFilter<TInputImage, TOutputImage>::HasForwardTransform() const
+{
+  return m_ForwardTransform.IsNotNull();
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+HessianGaussianImageFilter<TInputImage, TOutputImage>::CompletePass()
+{
+  ++m_NumberOfCompletedPasses;
+  this->UpdateProgress(static_cast<float>(m_NumberOfCompletedPasses) / static_cast<float>(m_NumberOfPasses));
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 HessianGaussianImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
-  os << "DerivativeFilter: " << m_DerivativeFilter << std::endl;
+  os << indent << "Sigma: " << m_Sigma << std::endl;
+  os << indent << "NormalizeAcrossScale: " << m_NormalizeAcrossScale << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "MaximumKernelWidth: " << m_MaximumKernelWidth << std::endl;
+  os << indent << "ConvolutionBackend: " << static_cast<int>(m_ConvolutionBackend) << std::endl;
+  os << indent << "InputSigma: " << m_InputSigma << std::endl;
+  os << indent << "PaddingSigma: " << m_PaddingSigma << std::endl;
 }
 
 } // end namespace itk
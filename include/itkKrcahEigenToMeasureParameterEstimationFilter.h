@@ -21,8 +21,8 @@
 
 #include "itkMath.h"
 #include "itkEigenToMeasureParameterEstimationFilter.h"
-#include <mutex>
 #include "itkCompensatedSummation.h"
+#include <vector>
 
 namespace itk
 {
@@ -67,6 +67,11 @@ namespace itk
  * If a mask is given, parameters are evaluated only where IsInside returns
  * true.
  *
+ * With a TargetRelativeError, \f$ T \f$ is the mean trace of a systematic
+ * sample of every piece, weighted by the number of pixels the sample stands
+ * for, and the half width of \f$ \gamma \f$ follows from the variance of the
+ * traces within the pieces.
+ *
  * \sa KrcahEigenToMeasureImageFilter
  * \sa EigenToMeasureParameterEstimationFilter
  * \sa MultiScaleHessianEnhancementImageFilter
@@ -92,6 +97,7 @@ public:
   using InputImagePointer = typename Superclass::InputImagePointer;
   using InputImageConstPointer = typename Superclass::InputImageConstPointer;
   using InputImageRegionType = typename Superclass::InputImageRegionType;
+  using InputImageIndexType = typename Superclass::InputImageIndexType;
   using InputImagePixelType = typename Superclass::InputImagePixelType;
   using PixelValueType = typename Superclass::PixelValueType;
 
@@ -103,12 +109,17 @@ public:
   /** Input Mask typedefs. */
   using MaskSpatialObjectType = typename Superclass::MaskSpatialObjectType;
   using MaskSpatialObjectTypeConstPointer = typename Superclass::MaskSpatialObjectTypeConstPointer;
+  using VoxelMaskType = typename Superclass::VoxelMaskType;
 
   /** Parameter typedefs */
   using RealType = typename Superclass::RealType;
   using ParameterArrayType = typename Superclass::ParameterArrayType;
   using ParameterDecoratedType = typename Superclass::ParameterDecoratedType;
 
+  /** Hessian typedefs */
+  using HessianPixelType = typename Superclass::HessianPixelType;
+  using HessianImageType = typename Superclass::HessianImageType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
@@ -135,6 +146,11 @@ public:
   itkSetEnumMacro(ParameterSet, KrcahImplementationEnum);
   itkGetEnumMacro(ParameterSet, KrcahImplementationEnum);
 
+  /** The journal trace, the sum of the eigenvalues, is the trace of the
+   * hessian. The implementation trace is not an invariant. */
+  bool
+  CanEstimateFromHessianInvariants() const override;
+
   /* Set parameter set */
   void
   SetParameterSetToImplementation()
@@ -170,6 +186,10 @@ protected:
   void
   DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
 
+  /** Sum the traces of the hessian. */
+  void
+  AccumulateHessianInvariants(const HessianImageType * hessian, const InputImageRegionType & region) override;
+
   /** Calculation of \f$ T \f$ changes depending on the implementation */
   inline RealType
   CalculateTraceAccordingToImplementation(InputImagePixelType pixel);
@@ -180,12 +200,37 @@ protected:
   PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
-  /* Member variables */
-  KrcahImplementationEnum        m_ParameterSet;
-  CompensatedSummation<RealType> m_ThreadCount;
-  CompensatedSummation<RealType> m_ThreadAccumulatedTrace;
+  /** Sums of the traces and of their squares, and number of pixels of a block */
+  struct BlockAccumulatorType
+  {
+    double        Trace;
+    double        SquaredTrace;
+    SizeValueType Count;
+  };
+
+  using TraceFunctionType = RealType (Self::*)(InputImagePixelType);
+
+  /** Accumulate traceOfPixel(pixel) over the pixels of a piece of the image,
+   * the input or the hessian, or over a sample of them meeting
+   * TargetRelativeError. */
+  template <typename TImage, typename TTrace>
+  void
+  AccumulateTracesOfPiece(const TImage * image, const InputImageRegionType & region, TTrace traceOfPixel);
+
+  /** Sums of the traces of one pixel out of every stride inside the mask in
+   * every block of the region. The squares are only summed for a sample. */
+  template <typename TImage, typename TTrace>
+  std::vector<BlockAccumulatorType>
+  AccumulateTraces(const TImage *               image,
+                   const InputImageRegionType & region,
+                   TTrace                       traceOfPixel,
+                   SizeValueType                stride);
 
-  std::mutex m_Mutex;
+  /* Member variables */
+  KrcahImplementationEnum      m_ParameterSet;
+  CompensatedSummation<double> m_AccumulatedTrace;
+  SizeValueType                m_NumberOfPixels;
+  double                       m_TraceSumVariance;
 }; // end class
 } // namespace itk
 
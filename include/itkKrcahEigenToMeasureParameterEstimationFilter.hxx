@@ -19,6 +19,9 @@
 #ifndef itkKrcahEigenToMeasureParameterEstimationFilter_hxx
 #define itkKrcahEigenToMeasureParameterEstimationFilter_hxx
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace itk
 {
@@ -26,6 +29,8 @@ namespace itk
 template <typename TInputImage, typename TOutputImage>
 KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::KrcahEigenToMeasureParameterEstimationFilter()
   : m_ParameterSet(KrcahImplementationEnum::UseImplementationParameters)
+  , m_NumberOfPixels(0)
+  , m_TraceSumVariance(0.0)
 {
   /* Set parameter size to 3 */
   ParameterArrayType parameters = this->GetParametersOutput()->Get();
@@ -40,8 +45,9 @@ template <typename TInputImage, typename TOutputImage>
 void
 KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::BeforeThreadedGenerateData()
 {
-  m_ThreadAccumulatedTrace = NumericTraits<RealType>::ZeroValue();
-  m_ThreadCount = NumericTraits<RealType>::ZeroValue();
+  m_AccumulatedTrace.ResetToZero();
+  m_NumberOfPixels = 0;
+  m_TraceSumVariance = 0.0;
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -68,11 +74,14 @@ KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AfterTh
   }
 
   /* Do derived measures */
-  const RealType accum(m_ThreadAccumulatedTrace);
-  const RealType count(m_ThreadCount);
-  if (count > 0)
+  ParameterArrayType halfWidths(3);
+  halfWidths.Fill(NumericTraits<RealType>::ZeroValue());
+  if (m_NumberOfPixels > 0)
   {
-    RealType averageTrace = accum / count;
+    const RealType averageTrace = static_cast<RealType>(m_AccumulatedTrace.GetSum() / m_NumberOfPixels);
+    const RealType averageTraceHalfWidth =
+      static_cast<RealType>(this->GetConfidenceFactor() * std::sqrt(m_TraceSumVariance) / m_NumberOfPixels);
+    halfWidths[2] = gamma * averageTraceHalfWidth;
     gamma = gamma * averageTrace;
   }
   else
@@ -87,6 +96,7 @@ KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AfterTh
   parameters[1] = beta;
   parameters[2] = gamma;
   this->GetParametersOutput()->Set(parameters);
+  this->GetParametersHalfWidthOutput()->Set(halfWidths);
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -102,7 +112,7 @@ KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::Dynamic
   }
 
   /* Determine which function to call */
-  RealType (Self::*traceFunction)(InputImagePixelType);
+  TraceFunctionType traceFunction;
   switch (m_ParameterSet)
   {
     case KrcahImplementationEnum::UseImplementationParameters:
@@ -116,60 +126,139 @@ KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::Dynamic
       break;
   }
 
-  /* Get input and mask pointer */
-  InputImageConstPointer            inputPointer = this->GetInput();
-  MaskSpatialObjectTypeConstPointer maskPointer = this->GetMask();
+  this->AccumulateTracesOfPiece(
+    this->GetInput(), outputRegionForThread, [this, traceFunction](const InputImagePixelType & pixel) -> RealType {
+      return (this->*traceFunction)(pixel);
+    });
+}
 
-  OutputImageType * outputPtr = this->GetOutput(0);
+template <typename TInputImage, typename TOutputImage>
+bool
+KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::CanEstimateFromHessianInvariants() const
+{
+  /* The sum of the absolute values of the eigenvalues is not an invariant */
+  return m_ParameterSet == KrcahImplementationEnum::UseJournalParameters;
+}
 
-  // Define the portion of the input to walk for this thread, using
-  // the CallCopyOutputRegionToInputRegion method allows for the input
-  // and output images to be different dimensions
-  InputImageRegionType inputRegionForThread;
+template <typename TInputImage, typename TOutputImage>
+void
+KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AccumulateHessianInvariants(
+  const HessianImageType *     hessian,
+  const InputImageRegionType & region)
+{
+  if (region.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
 
-  this->CallCopyOutputRegionToInputRegion(inputRegionForThread, outputRegionForThread);
+  /* The sum of the eigenvalues is the trace of the hessian */
+  this->AccumulateTracesOfPiece(hessian, region, [](const HessianPixelType & tensor) -> RealType {
+    return static_cast<RealType>(tensor.GetTrace());
+  });
+}
 
-  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage, typename TTrace>
+void
+KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AccumulateTracesOfPiece(
+  const TImage *               image,
+  const InputImageRegionType & region,
+  TTrace                       traceOfPixel)
+{
+  /* Every pixel is visited without a target. Otherwise a pilot sample of the
+   * piece estimates the variance of the traces, hence the stride meeting it. */
+  SizeValueType stride = 1;
+  if (this->GetTargetRelativeError() > 0.0)
+  {
+    const SizeValueType pilotStride = this->ComputePilotStride(region);
+    double              pilotTrace = 0.0;
+    double              pilotSquaredTrace = 0.0;
+    SizeValueType       pilotCount = 0;
+    for (const BlockAccumulatorType & block : this->AccumulateTraces(image, region, traceOfPixel, pilotStride))
+    {
+      pilotTrace += block.Trace;
+      pilotSquaredTrace += block.SquaredTrace;
+      pilotCount += block.Count;
+    }
+    if (pilotCount > 1)
+    {
+      const double mean = pilotTrace / pilotCount;
+      const double variance = std::max((pilotSquaredTrace - pilotCount * mean * mean) / (pilotCount - 1), 0.0);
+      stride = std::min(pilotStride,
+                        this->ComputeSamplingStride(mean, variance, static_cast<double>(pilotCount * pilotStride)));
+    }
+  }
 
-  mt->ParallelizeImageRegion<TInputImage::ImageDimension>(
-    outputRegionForThread,
-    [inputPointer, maskPointer, outputPtr, this, traceFunction](const OutputImageRegionType region) {
-      /* Keep track of the current accumulation */
-      RealType accum = NumericTraits<RealType>::ZeroValue();
-      RealType count = NumericTraits<RealType>::ZeroValue();
+  /* Merge in block order, so the sum does not depend on the work units. Every
+   * sample stands for stride pixels. */
+  CompensatedSummation<double> pieceTrace;
+  CompensatedSummation<double> pieceSquaredTrace;
+  SizeValueType                pieceCount = 0;
+  for (const BlockAccumulatorType & block : this->AccumulateTraces(image, region, traceOfPixel, stride))
+  {
+    m_AccumulatedTrace += stride * block.Trace;
+    m_NumberOfPixels += stride * block.Count;
+    pieceTrace += block.Trace;
+    pieceSquaredTrace += block.SquaredTrace;
+    pieceCount += block.Count;
+  }
 
-      typename InputImageType::PointType point;
+  /* The pieces are the strata of the sample. The variance of the estimated
+   * sum of the traces of the piece has a finite population correction. */
+  if (stride > 1 && pieceCount > 1)
+  {
+    const double count = static_cast<double>(pieceCount);
+    const double mean = pieceTrace.GetSum() / count;
+    const double variance = std::max((pieceSquaredTrace.GetSum() - count * mean * mean) / (count - 1.0), 0.0);
+    const double numberOfPixels = static_cast<double>(stride) * count;
+    m_TraceSumVariance += numberOfPixels * numberOfPixels * (1.0 - 1.0 / stride) * variance / count;
+  }
+}
 
-      /* Setup iterator */
-      ImageRegionConstIteratorWithIndex<TInputImage> inputIt(inputPointer, region);
-      ImageRegionIterator<OutputImageType>           outputIt(outputPtr, region);
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage, typename TTrace>
+std::vector<typename KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::BlockAccumulatorType>
+KrcahEigenToMeasureParameterEstimationFilter<TInputImage, TOutputImage>::AccumulateTraces(
+  const TImage *               image,
+  const InputImageRegionType & region,
+  TTrace                       traceOfPixel,
+  SizeValueType                stride)
+{
+  using PixelType = typename TImage::PixelType;
 
-      /* Iterate and count */
-      while (!inputIt.IsAtEnd())
-      {
-        // Process point
-        inputPointer->TransformIndexToPhysicalPoint(inputIt.GetIndex(), point);
-        if ((!maskPointer) || (maskPointer->IsInsideInObjectSpace(point)))
+  /* Sum the traces of every block in order, on a single work unit */
+  std::vector<BlockAccumulatorType> blocks(this->ComputeNumberOfBlocks(region));
+  this->ParallelizeBlocks(region, [&](SizeValueType block, const InputImageRegionType & blockRegion) {
+    CompensatedSummation<double> trace;
+    CompensatedSummation<double> squaredTrace;
+    SizeValueType                count = 0;
+    if (stride == 1)
+    {
+      this->VisitPixelsInsideMask(image, blockRegion, [&](const PixelType * pixels, SizeValueType n) {
+        double runTrace = 0.0;
+        for (SizeValueType i = 0; i < n; ++i)
         {
-          /* Compute trace */
-          count++;
-          accum += (this->*traceFunction)(inputIt.Get());
+          runTrace += traceOfPixel(pixels[i]);
         }
-
-        // Set
-        outputIt.Set(static_cast<OutputImagePixelType>(inputIt.Get()));
-
-        // Increment
-        ++inputIt;
-        ++outputIt;
-      }
-
-      /* Block and store */
-      std::lock_guard<std::mutex> mutexHolder(m_Mutex);
-      m_ThreadCount += count;
-      m_ThreadAccumulatedTrace += accum;
-    },
-    nullptr);
+        trace += runTrace;
+        count += n;
+      });
+    }
+    else
+    {
+      /* Shift the sample of every block so they do not line up */
+      this->VisitSampledPixelsInsideMask(image, blockRegion, stride, block, [&](const PixelType & pixel) {
+        const double pixelTrace = traceOfPixel(pixel);
+        trace += pixelTrace;
+        squaredTrace += pixelTrace * pixelTrace;
+        ++count;
+      });
+    }
+    blocks[block].Trace = trace.GetSum();
+    blocks[block].SquaredTrace = squaredTrace.GetSum();
+    blocks[block].Count = count;
+  });
+  return blocks;
 }
 
 template <typename TInputImage, typename TOutputImage>
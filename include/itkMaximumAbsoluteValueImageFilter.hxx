@@ -0,0 +1,62 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkMaximumAbsoluteValueImageFilter_hxx
+#define itkMaximumAbsoluteValueImageFilter_hxx
+
+#include "itkImageScanlineIterator.h"
+
+namespace itk
+{
+template <typename TInputImage1, typename TInputImage2, typename TOutputImage>
+void
+MaximumAbsoluteValueImageFilter<TInputImage1, TInputImage2, TOutputImage>::DynamicThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread)
+{
+  /* A constant input is a decorated pixel rather than an image */
+  const auto * input1 = dynamic_cast<const TInputImage1 *>(ProcessObject::GetInput(0));
+  const auto * input2 = dynamic_cast<const TInputImage2 *>(ProcessObject::GetInput(1));
+  if (!input1 || !input2)
+  {
+    Superclass::DynamicThreadedGenerateData(outputRegionForThread);
+    return;
+  }
+
+  const SizeValueType lineLength = outputRegionForThread.GetSize(0);
+  if (lineLength == 0)
+  {
+    return;
+  }
+
+  /* The pixels of a scanline are contiguous in the three images */
+  TOutputImage *                      outputPtr = this->GetOutput();
+  ImageScanlineIterator<TOutputImage> outputIt(outputPtr, outputRegionForThread);
+  while (!outputIt.IsAtEnd())
+  {
+    const typename TOutputImage::IndexType lineIndex = outputIt.GetIndex();
+    Functor::MaximumAbsoluteValueSpan(input1->GetBufferPointer() + input1->ComputeOffset(lineIndex),
+                                      input2->GetBufferPointer() + input2->ComputeOffset(lineIndex),
+                                      outputPtr->GetBufferPointer() + outputPtr->ComputeOffset(lineIndex),
+                                      lineLength);
+    outputIt.NextLine();
+  }
+}
+
+} // end namespace itk
+
+#endif // itkMaximumAbsoluteValueImageFilter_hxx
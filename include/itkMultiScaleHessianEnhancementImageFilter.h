@@ -20,13 +20,19 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkHessianGaussianImageFilter.h"
-#include "itkSymmetricEigenAnalysisImageFilter.h"
+#include "itkHessianGaussianCostModel.h"
+#include "itkCastImageFilter.h"
+#include "itkSymmetricEigenValuesImageFilter.h"
+#include "itkHessianGaussianEigenValuesImageFilter.h"
 #include "itkMaximumAbsoluteValueImageFilter.h"
+#include "itkStreamingImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkArray.h"
 #include "itkSpatialObject.h"
+#include "itkVoxelMask.h"
 #include "itkEigenToMeasureImageFilter.h"
 #include "itkEigenToMeasureParameterEstimationFilter.h"
+#include <type_traits>
 
 namespace itk
 {
@@ -35,8 +41,8 @@ namespace itk
  *
  * This class enhances an image using many of the bone image enhancement filters. Other filters based
  * on a functional of the eigenvalues can be written using this class by extending EigenToMeasureImageFilter.
- * This class works by computing the second derivative and cross derivatives usign HessianRecursiveGaussianImageFilter.
- * The hessian matrix is decomposed into the eigenvalues using SymmetricEigenAnalysisImageFilter. By setting a filter
+ * This class works by computing the second derivative and cross derivatives usign HessianGaussianImageFilter.
+ * The hessian matrix is decomposed into the eigenvalues using SymmetricEigenValuesImageFilter. By setting a filter
  * using SetEigenToMeasureImageFilter( ), a filter is used to convert eigenvalues back into a scalar values. This is
  * repeated at multiple scales and the maximum response (in an absolute sense) is taken over all scales.
  *
@@ -47,16 +53,18 @@ namespace itk
  * generate naturally spaced sigma values. Note that you still need to pass the array to SetSigmaArray( ).
  * Otherwise, an explicit SigmaArrayType can be passed to SetSigmaArray( ).
  *
- * The maximum response from SetEigenToMeasureImageFilter( ) is taken over all sigma values using
- * MaximumAbsoluteValueImageFilter. This is valid for filters which enhance both the positive and negative
- * second derivatives.
+ * The maximum response from SetEigenToMeasureImageFilter( ) is taken over all sigma values. The measures computed
+ * on the output grid are written in place into the response of the first scale, see
+ * EigenToMeasureImageFilter::SetAccumulator( ), so no image is allocated for them. The responses resampled from
+ * coarser grids are merged into it in place using MaximumAbsoluteValueImageFilter, each as soon as it is computed.
+ * This is valid for filters which enhance both the positive and negative second derivatives.
  *
  * This class is heavily derived from \see MultiScaleHessianBasedMeasureImageFilter
  *
  * \sa MaximumAbsoluteValueImageFilter
  * \sa EigenToMeasureImageFilter
- * \sa SymmetricEigenAnalysisImageFilter
- * \sa HessianRecursiveGaussianImageFilter
+ * \sa SymmetricEigenValuesImageFilter
+ * \sa HessianGaussianImageFilter
  *
  * \author: Bryce Besler
  * \ingroup BoneEnhancement
@@ -98,16 +106,99 @@ public:
   using MaskSpatialObjectType = SpatialObject<ImageDimension>;
   using MaskSpatialObjectTypeConstPointer = typename MaskSpatialObjectType::ConstPointer;
 
-  /** Methods to set/get the mask image */
+  /** Methods to set/get the mask image. The mask is rasterized once on the
+   * grid of the input, and the rasterization is shared by the parameter
+   * estimation and the measure at every scale evaluated on that grid. It is
+   * kept between updates while the mask and the grid of the input do not change.
+   * The parameters are estimated inside the mask and the response is zero
+   * outside of it. */
   itkSetInputMacro(ImageMask, MaskSpatialObjectType);
   itkGetInputMacro(ImageMask, MaskSpatialObjectType);
-
-  /** Hessian related typedefs. */
-  // using HessianFilterType = HessianRecursiveGaussianImageFilter< TInputImage >;
-  using HessianFilterType = HessianGaussianImageFilter<TInputImage>;
-  using HessianImageType = typename HessianFilterType::OutputImageType;
+  using VoxelMaskType = VoxelMask<ImageDimension>;
+
+  /** Set/Get whether the scales are only computed on the bounding region of
+   * the pixels inside the mask. The hessian filters read that region padded
+   * by the radius of their kernels, the eigenvalues, the parameters and the
+   * measure are computed on the region only, and the output is zero outside
+   * of it, as it is outside of the mask anyway. Scales evaluated on a coarser
+   * grid are computed on the coarse pixels covering the region. Ignored
+   * without a mask. Defaults to off.
+   * \sa GetOutputRegion */
+  itkSetMacro(CropToMask, bool);
+  itkGetConstMacro(CropToMask, bool);
+  itkBooleanMacro(CropToMask);
+
+  /** Hessian related typedefs. The hessian is computed from ScaleSpaceImageType,
+   * which also holds the smoothed images of incremental smoothing. Real inputs are
+   * read as they are, integer inputs are cast to float once. */
+  using InternalRealType = typename std::
+    conditional<std::is_floating_point<InputImagePixelType>::value, InputImagePixelType, float>::type;
+  using ScaleSpaceImageType = Image<InternalRealType, TInputImage::ImageDimension>;
+  using CastFilterType = CastImageFilter<TInputImage, ScaleSpaceImageType>;
+  using HessianImageType =
+    Image<SymmetricSecondRankTensor<typename NumericTraits<InputImagePixelType>::RealType, TInputImage::ImageDimension>,
+          TInputImage::ImageDimension>;
   using HessianPixelType = typename HessianImageType::PixelType;
-  using InternalRealType = typename HessianFilterType::InternalRealType;
+  using HessianFilterType = HessianGaussianImageFilter<ScaleSpaceImageType, HessianImageType>;
+  using ConvolutionBackendEnum = typename HessianFilterType::ConvolutionBackendEnum;
+
+  /** Set/Get the method used to compute the Gaussian derivatives at every scale.
+   * With ConvolutionBackendEnum::FFT the input is transformed once and the
+   * transform is shared by all the scales computed on the grid of the input.
+   * It is released after the last of them.
+   * \sa HessianGaussianImageFilter::SetConvolutionBackend */
+  itkSetEnumMacro(ConvolutionBackend, ConvolutionBackendEnum);
+  itkGetEnumMacro(ConvolutionBackend, ConvolutionBackendEnum);
+
+  /** Cost model used to select the backend automatically */
+  using CostModelType = HessianGaussianCostModel<ScaleSpaceImageType>;
+
+  /** Set/Get whether the backend is selected for every sigma as the one with
+   * the lowest cost predicted by the cost model, for the region the scale is
+   * computed on. The cost model is calibrated on the first update, or read
+   * from its calibration file. ConvolutionBackend is ignored when on. With
+   * PyramidEvaluation, a scale is only evaluated on a coarser grid when the
+   * cost model predicts it is cheaper than on the input grid. Defaults to off.
+   * \sa HessianGaussianCostModel */
+  itkSetMacro(AutomaticConvolutionBackend, bool);
+  itkGetConstMacro(AutomaticConvolutionBackend, bool);
+  itkBooleanMacro(AutomaticConvolutionBackend);
+
+  /** Set/Get whether the scales are computed incrementally. The scales are
+   * processed in increasing order and the input is smoothed from one scale to
+   * the next by the Gaussian of standard deviation sqrt(sigma_i^2 - sigma_{i-1}^2),
+   * the smoothed image of the previous scale being kept in between. The
+   * hessian is then computed from the smoothed image with the narrow kernels
+   * of the smallest sigma, so the cost of the derivatives does not grow with
+   * sigma. The result differs from direct evaluation by the discretization
+   * of the composed kernels. Defaults to off.
+   * \sa HessianGaussianImageFilter::SetInputSigma */
+  itkSetMacro(IncrementalSmoothing, bool);
+  itkGetConstMacro(IncrementalSmoothing, bool);
+  itkBooleanMacro(IncrementalSmoothing);
+
+  /** Set/Get whether the large scales are evaluated on a coarser grid. When
+   * sigma spans several voxels along a dimension, the image smoothed by half
+   * of sigma is downsampled along it by a power of two, averaging blocks of
+   * samples so the coarse grid stays centred on the fine one, keeping at least
+   * PyramidSamplesPerSigma samples per sigma. The hessian, the eigenvalues
+   * and the measure are computed on the coarse grid, the parameters of the
+   * measure being estimated there too, and the response is linearly
+   * interpolated back onto the output grid. With AutomaticConvolutionBackend
+   * the coarse grid is only used when cheaper. Defaults to off. */
+  itkSetMacro(PyramidEvaluation, bool);
+  itkGetConstMacro(PyramidEvaluation, bool);
+  itkBooleanMacro(PyramidEvaluation);
+
+  /** Set/Get the minimum number of samples per sigma kept by the pyramid. It
+   * cannot be smaller than two so the smoothing before downsampling is at
+   * least one coarse spacing. Defaults to two. */
+  itkSetClampMacro(PyramidSamplesPerSigma, double, 2.0, NumericTraits<double>::max());
+  itkGetConstMacro(PyramidSamplesPerSigma, double);
+
+  /** Set/Get the cost model. */
+  itkSetObjectMacro(CostModel, CostModelType);
+  itkGetModifiableObjectMacro(CostModel, CostModelType);
 
   /** Eigenvalue analysis related type alias. The ITK python wrapping usually wraps floating types
    * and not double types. For this reason, the eigenvalues are of type float.
@@ -116,7 +207,17 @@ public:
   using FloatType = typename NumericTraits<InputImagePixelType>::FloatType;
   using EigenValueArrayType = Vector<FloatType, HessianPixelType::Dimension>;
   using EigenValueImageType = Image<EigenValueArrayType, TInputImage::ImageDimension>;
-  using EigenAnalysisFilterType = SymmetricEigenAnalysisImageFilter<HessianImageType, EigenValueImageType>;
+  using EigenAnalysisFilterType = SymmetricEigenValuesImageFilter<HessianImageType, EigenValueImageType>;
+  using FusedEigenAnalysisFilterType = HessianGaussianEigenValuesImageFilter<ScaleSpaceImageType, EigenValueImageType>;
+
+  /** Set/Get whether the eigenvalues are computed by
+   * HessianGaussianEigenValuesImageFilter, which never stores the hessian
+   * image, instead of HessianGaussianImageFilter followed by
+   * SymmetricEigenValuesImageFilter. Only the scales computed with
+   * ConvolutionBackendEnum::Discrete are fused. Defaults to off. */
+  itkSetMacro(FusedEigenAnalysis, bool);
+  itkGetConstMacro(FusedEigenAnalysis, bool);
+  itkBooleanMacro(FusedEigenAnalysis);
 
   /** Maximum over scale related type alias. */
   using MaximumAbsoluteValueFilterType = MaximumAbsoluteValueImageFilter<TOutputImage>;
@@ -137,6 +238,49 @@ public:
   itkSetObjectMacro(EigenToMeasureParameterEstimationFilter, EigenToMeasureParameterEstimationFilterType);
   itkGetModifiableObjectMacro(EigenToMeasureParameterEstimationFilter, EigenToMeasureParameterEstimationFilterType);
 
+  /** Set/Get whether the parameters are estimated from the trace and the
+   * Frobenius norm of the hessian, which are those of the eigenvalues, when
+   * the estimation filter supports it. The eigen analysis and the measure
+   * are then streamed together in the pieces of the memory budget of the
+   * estimation filter, so the eigenvalues of the whole scale are never
+   * buffered.
+   *
+   * With a memory budget, the hessian is reduced piece by piece before the
+   * measure and computed again by it, as with TwoPassStreaming but without
+   * a first eigen analysis. Without one, the hessian of the whole scale is
+   * buffered, six doubles per pixel, and reused by the measure, which takes
+   * more memory than the eigenvalues it avoids. Scales computed by the fused
+   * eigen analysis, which never buffers the hessian, estimate from the
+   * eigenvalues. Defaults to off.
+   * \sa EigenToMeasureParameterEstimationFilter::CanEstimateFromHessianInvariants */
+  itkSetMacro(HessianInvariantEstimation, bool);
+  itkGetConstMacro(HessianInvariantEstimation, bool);
+  itkBooleanMacro(HessianInvariantEstimation);
+
+  /** Set/Get whether every scale is computed in two streamed passes. The
+   * first pass streams the hessian and the eigenvalues through the
+   * estimation filter, which only accumulates the parameters. The second
+   * pass streams them again through the measure. Both passes use the pieces
+   * of the memory budget of the estimation filter, so the memory of a scale
+   * is that of a piece and the response, at the price of computing the
+   * eigenvalues twice. The memory is only bounded for the scales computed
+   * with ConvolutionBackendEnum::Discrete, the other backends compute the
+   * hessian of the whole scale at once. Takes precedence over
+   * HessianInvariantEstimation. Defaults to off.
+   *
+   * In a single pass without a memory budget, the eigenvalues of a scale are
+   * computed once and read in place by the estimation and the measure. With
+   * a budget, the estimation streams them in pieces and copies every piece
+   * into its output, which holds the eigenvalues of the whole scale for the
+   * measure.
+   * \sa EigenToMeasureParameterEstimationFilter::SetMemoryBudget */
+  itkSetMacro(TwoPassStreaming, bool);
+  itkGetConstMacro(TwoPassStreaming, bool);
+  itkBooleanMacro(TwoPassStreaming);
+  using ParameterArrayType = typename EigenToMeasureParameterEstimationFilterType::ParameterArrayType;
+  using ParameterDecoratedType = typename EigenToMeasureParameterEstimationFilterType::ParameterDecoratedType;
+  using MeasureStreamingFilterType = StreamingImageFilter<TOutputImage, TOutputImage>;
+
   /** Sigma values. */
   using SigmaType = RealType;
   using SigmaArrayType = Array<SigmaType>;
@@ -159,6 +303,15 @@ public:
   itkSetMacro(SigmaArray, SigmaArrayType);
   itkGetConstMacro(SigmaArray, SigmaArrayType);
 
+  /** Set/Get the sigmas the parameters are estimated at, once before the
+   * scales. The parameters are averaged over these sigmas and used by the
+   * measure at every scale, which then streams the eigenvalues straight into
+   * the measure. A single sigma estimates at a reference scale, a few sigmas
+   * of SigmaArray pool a subsample of the scales. When empty, the default,
+   * every scale estimates its own parameters. */
+  itkSetMacro(EstimationSigmaArray, SigmaArrayType);
+  itkGetConstMacro(EstimationSigmaArray, SigmaArrayType);
+
   /**
    * Static methods for generating an array of sigma values. Note that these still need to be passed
    * into the class using SetSigmaArray. Implementation taken from itkMultiScaleHessianBasedMeasureImageFilter.
@@ -189,9 +342,73 @@ protected:
   void
   GenerateData() override;
 
-  /** Internal function to generate the response at a scale */
+  /** Internal function to generate the response at a scale. When the
+   * measure is computed on the output grid it is accumulated into the
+   * accumulator, if any, which is returned. */
   inline typename TOutputImage::Pointer
-  generateResponseAtScale(SigmaStepsType scaleLevel);
+  generateResponseAtScale(SigmaType thisSigma, TOutputImage * accumulator);
+
+  /** Connect the hessian, the eigen analysis and the estimation for a
+   * scale. Returns the grid the scale is evaluated on. */
+  const ImageBase<ImageDimension> *
+  SetUpScale(SigmaType thisSigma);
+
+  /** Estimate the parameters of the scale set up over the region of its
+   * grid, without passing the eigenvalues through */
+  ParameterArrayType
+  EstimateParametersAtScale(const OutputImageRegionType & region);
+
+  /** Whether the parameters of the scale set up are estimated from the
+   * invariants of its hessian */
+  bool
+  EstimatesFromHessianInvariants() const;
+
+  /** Stream the measure over the region with the parameters of the scale,
+   * into the accumulator of the measure if it has one */
+  typename TOutputImage::Pointer
+  StreamMeasure(const OutputImageRegionType & region);
+
+  /** Smooth the image of the previous scale, or the input, up to the given sigma */
+  void
+  UpdateScaleSpaceImage(SigmaType smoothingSigma);
+
+  /** The input itself when it is a ScaleSpaceImageType, otherwise the input cast to it */
+  const ScaleSpaceImageType *
+  GetScaleSpaceInput();
+
+  /** Downsampling factors of the grid a scale is evaluated on */
+  using ShrinkFactorsType = FixedArray<unsigned int, TInputImage::ImageDimension>;
+  ShrinkFactorsType
+  GetShrinkFactors(SigmaType thisSigma) const;
+
+  /** Whether the cost model predicts a scale is cheaper on the grid shrunk
+   * by the factors, smoothing included, than on the input grid */
+  bool
+  IsDownsamplingCheaper(SigmaType thisSigma, const ShrinkFactorsType & shrinkFactors) const;
+
+  /** Whether a scale from the first one on is computed with the FFT backend
+   * from the forward transform of the input, which is otherwise released */
+  bool
+  ReusesForwardTransform(const SigmaArrayType & sigmas, SigmaStepsType first) const;
+
+  /** Share of the progress of a scale, the number of pixels of its grid
+   * covering the region the scales are computed on */
+  double
+  GetProgressShareOfScale(SigmaType thisSigma) const;
+
+  /** Split the share of the progress of a scale evenly over the
+   * computations of its hessian */
+  void
+  StartProgressOfScale(SigmaType thisSigma, unsigned int numberOfHessianPasses);
+
+  /** Complete a computation of the hessian of the scale, and stop if the
+   * filter was aborted */
+  void
+  CompleteProgressPass();
+
+  /** Forward the progress of the hessian filters within the current pass */
+  void
+  ReportPassProgress(Object * caller, const EventObject & event);
 
   /** Internal function to convert types for EigenValueOrder */
   InternalEigenValueOrderType
@@ -201,9 +418,18 @@ protected:
   void
   GenerateInputRequestedRegion() override;
 
+  /** Region of the output the scales are computed on. It is the bounding
+   * region of the mask rasterized on the grid of the input with CropToMask,
+   * the largest possible region otherwise. */
   OutputImageRegionType
   GetOutputRegion();
 
+  /** Region of the grid of a scale covering the region the scales are
+   * computed on, padded by a pixel for the interpolation back onto the
+   * output grid when the grids differ. */
+  OutputImageRegionType
+  GetOutputRegionOnGrid(const ImageBase<ImageDimension> * grid) const;
+
   /** Override since the filter produces all of its output */
   void
   EnlargeOutputRequestedRegion(DataObject * data) override;
@@ -213,14 +439,55 @@ protected:
 
 private:
   /** Internal filters. */
+  typename CastFilterType::Pointer                              m_CastFilter;
   typename HessianFilterType::Pointer                           m_HessianFilter;
   typename EigenAnalysisFilterType::Pointer                     m_EigenAnalysisFilter;
+  typename FusedEigenAnalysisFilterType::Pointer                m_FusedEigenAnalysisFilter;
   typename MaximumAbsoluteValueFilterType::Pointer              m_MaximumAbsoluteValueFilter;
   typename EigenToMeasureImageFilterType::Pointer               m_EigenToMeasureImageFilter;
   typename EigenToMeasureParameterEstimationFilterType::Pointer m_EigenToMeasureParameterEstimationFilter;
+  typename MeasureStreamingFilterType::Pointer                  m_MeasureStreamingFilter;
 
   /** Sigma member variables. */
   SigmaArrayType m_SigmaArray;
+  SigmaArrayType m_EstimationSigmaArray;
+
+  ConvolutionBackendEnum m_ConvolutionBackend;
+
+  /** Automatic selection of the backend */
+  bool                            m_AutomaticConvolutionBackend;
+  typename CostModelType::Pointer m_CostModel;
+
+  /** Incremental smoothing across scales */
+  bool                                       m_IncrementalSmoothing;
+  typename ScaleSpaceImageType::ConstPointer m_ScaleSpaceImage;
+  SigmaType                                  m_ScaleSpaceImageSigma;
+  SigmaType                                  m_DerivativeSigma;
+
+  /** Evaluation of the large scales on coarser grids */
+  bool   m_PyramidEvaluation;
+  double m_PyramidSamplesPerSigma;
+
+  /** Hessian and eigenvalues computed by tiles */
+  bool m_FusedEigenAnalysis;
+
+  /** Mask rasterized on the grid of the input */
+  typename VoxelMaskType::Pointer m_VoxelMask;
+
+  /** Parameters of a scale estimated before its measure, held apart from the
+   * estimation filter so the measure does not update it */
+  bool                                     m_HessianInvariantEstimation;
+  bool                                     m_TwoPassStreaming;
+  typename ParameterDecoratedType::Pointer m_ScaleParameters;
+
+  /** Cropping to the bounding region of the mask */
+  bool                  m_CropToMask;
+  OutputImageRegionType m_OutputRegion;
+
+  /** Progress over the computations of the hessian of the scales */
+  double m_ProgressTotal;
+  double m_ProgressDone;
+  double m_ProgressPassWeight;
 
 }; // end of class
 } // end namespace itk
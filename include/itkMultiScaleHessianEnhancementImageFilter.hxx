@@ -19,23 +19,60 @@
 #define itkMultiScaleHessianEnhancementImageFilter_hxx
 
 #include "itkMath.h"
-#include "itkProgressAccumulator.h"
+#include "itkImageAlgorithm.h"
+#include "itkCommand.h"
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkBinShrinkImageFilter.h"
+#include "itkResampleImageFilter.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNearestNeighborExtrapolateImageFunction.h"
+#include <algorithm>
 
 namespace itk
 {
 template <typename TInputImage, typename TOutputImage>
 MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::MultiScaleHessianEnhancementImageFilter()
+  : m_ConvolutionBackend(ConvolutionBackendEnum::Discrete)
+  , m_AutomaticConvolutionBackend(false)
+  , m_IncrementalSmoothing(false)
+  , m_ScaleSpaceImageSigma(0.0)
+  , m_DerivativeSigma(0.0)
+  , m_PyramidEvaluation(false)
+  , m_PyramidSamplesPerSigma(2.0)
+  , m_FusedEigenAnalysis(false)
+  , m_HessianInvariantEstimation(false)
+  , m_TwoPassStreaming(false)
+  , m_CropToMask(false)
+  , m_ProgressTotal(0.0)
+  , m_ProgressDone(0.0)
+  , m_ProgressPassWeight(0.0)
 {
   /* Sigma member variables */
   m_SigmaArray.SetSize(0);
+  m_EstimationSigmaArray.SetSize(0);
 
   /* Instantiate filters. */
+  m_CastFilter = CastFilterType::New();
+  m_CastFilter->InPlaceOff();
   m_HessianFilter = HessianFilterType::New();
   m_EigenAnalysisFilter = EigenAnalysisFilterType::New();
+  m_FusedEigenAnalysisFilter = FusedEigenAnalysisFilterType::New();
   m_MaximumAbsoluteValueFilter = MaximumAbsoluteValueFilterType::New();
+  m_MaximumAbsoluteValueFilter->InPlaceOn();
+  m_MeasureStreamingFilter = MeasureStreamingFilterType::New();
+  m_ScaleParameters = ParameterDecoratedType::New();
+  m_CostModel = CostModelType::New();
+  m_VoxelMask = VoxelMaskType::New();
   m_EigenToMeasureImageFilter = nullptr;               // has to be provided by the user.
   m_EigenToMeasureParameterEstimationFilter = nullptr; // has to be provided by the user.
 
+  /* The hessian filters report the progress within a computation of the hessian */
+  using CommandType = MemberCommand<Self>;
+  typename CommandType::Pointer progressCommand = CommandType::New();
+  progressCommand->SetCallbackFunction(this, &Self::ReportPassProgress);
+  m_HessianFilter->AddObserver(ProgressEvent(), progressCommand);
+  m_FusedEigenAnalysisFilter->AddObserver(ProgressEvent(), progressCommand);
+
   /* We require an input image */
   this->SetNumberOfRequiredInputs(1);
 }
@@ -64,32 +101,7 @@ MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::EnlargeOutpu
   Superclass::EnlargeOutputRequestedRegion(data);
   OutputImagePointer imgData = dynamic_cast<TOutputImage *>(data);
 
-  // if ( this->GetInput() )
-  // {
-  //   OutputImageRegionType region = this->GetOutputRegion();
-  //   // crop the input requested region at the input's largest possible region
-  //   if ( region.Crop( imgData->GetLargestPossibleRegion() ) )
-  //   {
-  //     imgData->SetRequestedRegion(region);
-  //     return;
-  //   }
-  //   else
-  //   {
-  //     // Couldn't crop the region (requested region is outside the largest
-  //     // possible region).  Throw an exception.
-
-  //     // store what we tried to request (prior to trying to crop)
-  //     imgData->SetRequestedRegion(region);
-
-  //     // build an exception
-  //     InvalidRequestedRegionError e(__FILE__, __LINE__);
-  //     e.SetLocation(ITK_LOCATION);
-  //     e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
-  //     e.SetDataObject(imgData);
-  //     throw e;
-  //   }
-  // }
-  // else
+  /* Even when cropping to the mask, the output is zero outside of the region the scales are computed on */
   if (imgData)
   {
     imgData->SetRequestedRegionToLargestPossibleRegion();
@@ -119,22 +131,75 @@ MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GenerateData
 
   /* Set filters parameters */
   m_HessianFilter->SetNormalizeAcrossScale(true);
-  m_EigenAnalysisFilter->SetDimension(ImageDimension);
-  m_EigenAnalysisFilter->OrderEigenValuesBy(this->ConvertType(m_EigenToMeasureImageFilter->GetEigenValueOrder()));
+  m_HessianFilter->SetConvolutionBackend(m_ConvolutionBackend);
+  if (m_AutomaticConvolutionBackend)
+  {
+    /* Calibrate for the settings of the hessian filter, only done once per number of work units */
+    m_CostModel->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    m_CostModel->SetMaximumError(m_HessianFilter->GetMaximumError());
+    m_CostModel->SetMaximumKernelWidth(m_HessianFilter->GetMaximumKernelWidth());
+    m_CostModel->Calibrate();
+  }
+
+  /* Process the scales in increasing order, the maximum over scales does not depend on it */
+  SigmaArrayType sortedSigmaArray = m_SigmaArray;
+  std::sort(sortedSigmaArray.begin(), sortedSigmaArray.end());
+
+  /* The parameters are estimated in increasing order of the estimation sigmas too */
+  SigmaArrayType sortedEstimationSigmaArray = m_EstimationSigmaArray;
+  std::sort(sortedEstimationSigmaArray.begin(), sortedEstimationSigmaArray.end());
+  SigmaType smallestSigma = sortedSigmaArray[0];
+  SigmaType largestSigma = sortedSigmaArray[sortedSigmaArray.GetSize() - 1];
+  if (sortedEstimationSigmaArray.GetSize() > 0)
+  {
+    smallestSigma = std::min(smallestSigma, sortedEstimationSigmaArray[0]);
+    largestSigma = std::max(largestSigma, sortedEstimationSigmaArray[sortedEstimationSigmaArray.GetSize() - 1]);
+  }
+
+  /* Pad for the largest sigma so the FFT backend transforms the input once for all scales. With
+   * incremental smoothing or the pyramid the input of the hessian filter changes between scales. */
+  m_HessianFilter->SetPaddingSigma(m_IncrementalSmoothing || m_PyramidEvaluation ? 0.0 : largestSigma);
+  m_HessianFilter->SetInputSigma(0.0);
+  m_ScaleSpaceImage = nullptr;
+  m_ScaleSpaceImageSigma = 0.0;
+  m_DerivativeSigma = smallestSigma;
+  m_EigenAnalysisFilter->SetEigenValueOrder(this->ConvertType(m_EigenToMeasureImageFilter->GetEigenValueOrder()));
+  m_FusedEigenAnalysisFilter->SetNormalizeAcrossScale(true);
+  m_FusedEigenAnalysisFilter->SetMaximumError(m_HessianFilter->GetMaximumError());
+  m_FusedEigenAnalysisFilter->SetMaximumKernelWidth(m_HessianFilter->GetMaximumKernelWidth());
+  m_FusedEigenAnalysisFilter->SetEigenValueOrder(m_EigenAnalysisFilter->GetEigenValueOrder());
+  m_FusedEigenAnalysisFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
 
   /* Connect filters */
-  m_HessianFilter->SetInput(this->GetInput());
+  m_HessianFilter->SetInput(this->GetScaleSpaceInput());
   m_EigenAnalysisFilter->SetInput(m_HessianFilter->GetOutput());
   m_EigenToMeasureParameterEstimationFilter->SetInput(m_EigenAnalysisFilter->GetOutput());
   m_EigenToMeasureImageFilter->SetInput(m_EigenToMeasureParameterEstimationFilter->GetOutput());
   m_EigenToMeasureImageFilter->SetParametersInput(m_EigenToMeasureParameterEstimationFilter->GetParametersOutput());
 
-  /* Set the mask */
+  /* Set the mask, rasterized once for every filter and every scale on the grid of the input */
   MaskSpatialObjectTypeConstPointer mask = this->GetImageMask();
+  const VoxelMaskType *             voxelMask = nullptr;
   if (mask)
   {
-    m_EigenToMeasureParameterEstimationFilter->SetMask(mask);
-    m_EigenToMeasureParameterEstimationFilter->SetMask(mask);
+    if (!m_VoxelMask->IsRasterizationOf(mask, this->GetInput()))
+    {
+      m_VoxelMask->Rasterize(mask, this->GetInput(), this->GetMultiThreader(), this->GetNumberOfWorkUnits());
+    }
+    voxelMask = m_VoxelMask;
+  }
+  m_EigenToMeasureParameterEstimationFilter->SetMask(mask);
+  m_EigenToMeasureParameterEstimationFilter->SetVoxelMask(voxelMask);
+  m_EigenToMeasureImageFilter->SetMask(mask);
+  m_EigenToMeasureImageFilter->SetVoxelMask(voxelMask);
+
+  /* Nothing to compute when no pixel is inside the mask */
+  m_OutputRegion = this->GetOutputRegion();
+  if (m_OutputRegion.GetNumberOfPixels() == 0)
+  {
+    this->AllocateOutputs();
+    this->GetOutput()->FillBuffer(NumericTraits<OutputImagePixelType>::ZeroValue());
+    return;
   }
 
   /* After executing we want to release data to save memory */
@@ -144,107 +209,600 @@ MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GenerateData
   // m_EigenToMeasureParameterEstimationFilter->ReleaseDataFlagOn();
   // m_MaximumAbsoluteValueFilter->ReleaseDataFlagOn();
 
-  /* Setup progress reporter */
-  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
-  progress->SetMiniPipelineFilter(this);
-
-  /*
-   * We checked that m_SigmaArray.GetSize() > 0 above and do not need to repeat the check. However,
-   * if we are only given one sigma value we do not need to take the maximum over scales.
-   *
-   * Two filters, ran m_SigmaArray.GetSize() times
-   * One filter, ran (m_SigmaArray.GetSize() - 1) times
-   *
-   * We do not count the hessian or eigenanalysis filters since they will be streamed many times.
-   */
-  float numberOfFiltersToProcess = 2 * m_SigmaArray.GetSize() + 1 * (m_SigmaArray.GetSize() - 1);
-  float perFilterProccessPercentage = 1.0 / numberOfFiltersToProcess;
-  itkDebugMacro(<< "each filter accounts for " << perFilterProccessPercentage * 100.0 << "% of processing");
-
-
-  progress->RegisterInternalFilter(m_EigenToMeasureParameterEstimationFilter,
-                                   1.5 * m_SigmaArray.GetSize() * perFilterProccessPercentage);
-  progress->RegisterInternalFilter(m_EigenToMeasureImageFilter,
-                                   0.5 * m_SigmaArray.GetSize() * perFilterProccessPercentage);
-
-  /* Check if we need to run the MaximumAbsoluteValueFilter at all */
-  if (m_SigmaArray.GetSize() > 1)
+  /* The computations of the hessian dominate the run time. Every scale, and every estimation sigma, has a share of
+   * the progress in proportion to the pixels of its grid, split over the computations of the hessian it runs. */
+  m_ProgressTotal = 0.0;
+  m_ProgressDone = 0.0;
+  for (const SigmaType sigma : sortedEstimationSigmaArray)
   {
-    progress->RegisterInternalFilter(m_MaximumAbsoluteValueFilter,
-                                     (m_SigmaArray.GetSize() - 1) * perFilterProccessPercentage);
+    m_ProgressTotal += this->GetProgressShareOfScale(sigma);
   }
-  else
+  for (const SigmaType sigma : sortedSigmaArray)
   {
-    itkDebugMacro(<< "maximumAbsoluteValueFilter is not being used");
+    m_ProgressTotal += this->GetProgressShareOfScale(sigma);
   }
 
-  /* We store a single pointer that we will graft to the output */
-  typename TOutputImage::Pointer outputImagePointer;
+  /* Estimate the parameters once, averaged over the estimation sigmas */
+  const unsigned int numberOfEstimationSigmas = m_EstimationSigmaArray.GetSize();
+  if (numberOfEstimationSigmas > 0)
+  {
+    ParameterArrayType parameters;
+    for (unsigned int i = 0; i < numberOfEstimationSigmas; ++i)
+    {
+      const ImageBase<ImageDimension> * grid = this->SetUpScale(sortedEstimationSigmaArray[i]);
+      this->StartProgressOfScale(sortedEstimationSigmaArray[i], 1);
+      const ParameterArrayType scaleParameters = this->EstimateParametersAtScale(this->GetOutputRegionOnGrid(grid));
+      this->CompleteProgressPass();
+      if (i == 0)
+      {
+        parameters = scaleParameters;
+      }
+      else
+      {
+        for (unsigned int j = 0; j < parameters.GetSize(); ++j)
+        {
+          parameters[j] += scaleParameters[j];
+        }
+      }
+    }
+    for (unsigned int j = 0; j < parameters.GetSize(); ++j)
+    {
+      parameters[j] /= numberOfEstimationSigmas;
+    }
+    m_ScaleParameters->Set(parameters);
 
-  /* Process the first scale */
-  outputImagePointer = generateResponseAtScale((SigmaStepsType)0);
+    if (!this->ReusesForwardTransform(sortedSigmaArray, 0))
+    {
+      m_HessianFilter->ReleaseForwardTransform();
+    }
+  }
 
-  /* Process the remaining sigma values */
-  for (SigmaStepsType scaleLevel = 1; scaleLevel < m_SigmaArray.GetSize(); ++scaleLevel)
+  /* The measures on the output grid are accumulated into the first response in place. A response resampled from
+   * a coarser grid is merged into it as soon as it is computed, so at most one response is held besides it. */
+  typename TOutputImage::Pointer outputImagePointer;
+  for (SigmaStepsType scaleLevel = 0; scaleLevel < sortedSigmaArray.GetSize(); ++scaleLevel)
   {
-    /* Calculate next response value */
-    typename TOutputImage::Pointer tempResponseImagePointer = generateResponseAtScale(scaleLevel);
+    typename TOutputImage::Pointer response =
+      generateResponseAtScale(sortedSigmaArray[scaleLevel], outputImagePointer.GetPointer());
+
+    /* The transform of the input is released after the last scale reusing it */
+    if (!this->ReusesForwardTransform(sortedSigmaArray, scaleLevel + 1))
+    {
+      m_HessianFilter->ReleaseForwardTransform();
+    }
+
+    if (outputImagePointer.IsNull())
+    {
+      outputImagePointer = response;
+      continue;
+    }
+    if (response == outputImagePointer)
+    {
+      continue;
+    }
 
-    /* Take absolute value maximum */
     m_MaximumAbsoluteValueFilter->SetInput1(outputImagePointer);
-    m_MaximumAbsoluteValueFilter->SetInput2(tempResponseImagePointer);
-    // m_MaximumAbsoluteValueFilter->GetOutput()->SetRequestedRegion(this->GetOutputRegion());
+    m_MaximumAbsoluteValueFilter->SetInput2(response);
+    m_MaximumAbsoluteValueFilter->GetOutput()->SetRequestedRegion(m_OutputRegion);
     m_MaximumAbsoluteValueFilter->Update();
 
-    /* Save max and go to next sigma value */
+    /* Save max and go to next sigma value. The next update of the filter must not overwrite it. */
     outputImagePointer = m_MaximumAbsoluteValueFilter->GetOutput();
+    outputImagePointer->DisconnectPipeline();
+
+    /* The filter must not hold the responses */
+    m_MaximumAbsoluteValueFilter->PopBackInput();
+    m_MaximumAbsoluteValueFilter->PopBackInput();
   }
 
+  /* The smoothed image is not needed anymore */
+  m_HessianFilter->SetInput(this->GetScaleSpaceInput());
+  m_FusedEigenAnalysisFilter->SetInput(this->GetScaleSpaceInput());
+  m_ScaleSpaceImage = nullptr;
+
   /* Graft output and we're done! */
-  this->GraftOutput(outputImagePointer);
+  if (m_OutputRegion == this->GetInput()->GetLargestPossibleRegion())
+  {
+    this->GraftOutput(outputImagePointer);
+  }
+  else
+  {
+    /* Paste the response on the cropped region into a zero output */
+    this->AllocateOutputs();
+    OutputImageType * output = this->GetOutput();
+    output->FillBuffer(NumericTraits<OutputImagePixelType>::ZeroValue());
+    ImageAlgorithm::Copy(outputImagePointer.GetPointer(), output, m_OutputRegion, m_OutputRegion);
+  }
 }
 
 template <typename TInputImage, typename TOutputImage>
 typename TOutputImage::Pointer
-MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::generateResponseAtScale(SigmaStepsType scaleLevel)
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::StreamMeasure(const OutputImageRegionType & region)
 {
-  /* Get this sigma value */
-  SigmaType thisSigma = m_SigmaArray.GetElement(scaleLevel);
+  /* The input of the measure is computed again for every piece, in the pieces of the memory budget */
+  m_EigenToMeasureImageFilter->SetParametersInput(m_ScaleParameters);
+  const unsigned int numberOfPieces = m_EigenToMeasureParameterEstimationFilter->ComputeNumberOfPieces(region);
+
+  TOutputImage * accumulator = m_EigenToMeasureImageFilter->GetAccumulator();
+  if (accumulator)
+  {
+    /* Every piece is written straight into the accumulator, there is no image to assemble them into. The output
+     * buffers the whole accumulator after the first piece, so the measure is told to run again for the next. */
+    const ImageRegionSplitterBase * splitter = m_MeasureStreamingFilter->GetRegionSplitter();
+    const unsigned int              numberOfSplits = splitter->GetNumberOfSplits(region, numberOfPieces);
+    for (unsigned int piece = 0; piece < numberOfSplits; ++piece)
+    {
+      OutputImageRegionType pieceRegion = region;
+      splitter->GetSplit(piece, numberOfSplits, pieceRegion);
+      m_EigenToMeasureImageFilter->Modified();
+      m_EigenToMeasureImageFilter->GetOutput()->SetRequestedRegion(pieceRegion);
+      m_EigenToMeasureImageFilter->Update();
+    }
+    return accumulator;
+  }
+
+  if (numberOfPieces == 1)
+  {
+    /* The streaming filter would only copy the output of the measure */
+    m_EigenToMeasureImageFilter->GetOutput()->SetRequestedRegion(region);
+    m_EigenToMeasureImageFilter->Update();
+    return m_EigenToMeasureImageFilter->GetOutput();
+  }
+
+  m_MeasureStreamingFilter->SetInput(m_EigenToMeasureImageFilter->GetOutput());
+  m_MeasureStreamingFilter->SetNumberOfStreamDivisions(numberOfPieces);
+  m_MeasureStreamingFilter->GetOutput()->SetRequestedRegion(region);
+  m_MeasureStreamingFilter->Update();
+  return m_MeasureStreamingFilter->GetOutput();
+}
+
+template <typename TInputImage, typename TOutputImage>
+const ImageBase<TInputImage::ImageDimension> *
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::SetUpScale(SigmaType thisSigma)
+{
+  /* Choose the grid of this scale */
+  const ShrinkFactorsType           shrinkFactors = this->GetShrinkFactors(thisSigma);
+  const ImageBase<ImageDimension> * grid = this->GetInput();
+  bool                              downsample = false;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    downsample = downsample || shrinkFactors[i] > 1;
+  }
 
-  /* Process pipeline and return */
+  if (downsample)
+  {
+    /* Smooth by half of sigma before dropping samples, which is at least one coarse spacing */
+    this->UpdateScaleSpaceImage(0.5 * thisSigma);
+
+    /* Average blocks of samples rather than pick one of them, so each coarse sample lies at the centre of the fine
+     * samples it replaces. Picking a sample misplaces the grid by up to half a fine spacing with even factors. The
+     * box adds little blur next to the smoothing and is not accounted for in the scale. */
+    using ShrinkFilterType = BinShrinkImageFilter<ScaleSpaceImageType, ScaleSpaceImageType>;
+    typename ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
+    shrinkFilter->SetInput(m_ScaleSpaceImage);
+    shrinkFilter->SetShrinkFactors(shrinkFactors);
+    shrinkFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    shrinkFilter->Update();
+
+    typename ScaleSpaceImageType::Pointer coarseImage = shrinkFilter->GetOutput();
+    coarseImage->DisconnectPipeline();
+    m_HessianFilter->SetInput(coarseImage);
+    m_HessianFilter->SetInputSigma(m_ScaleSpaceImageSigma);
+    grid = coarseImage;
+  }
+  else if (m_IncrementalSmoothing)
+  {
+    /* The derivatives are always taken with kernels of the smallest sigma. The rest of the blur comes from the
+     * smoothed image, so the hessian at sigma uses the image smoothed by sqrt(sigma^2 - m_DerivativeSigma^2). */
+    this->UpdateScaleSpaceImage(
+      std::sqrt(std::max(thisSigma * thisSigma - m_DerivativeSigma * m_DerivativeSigma, 0.0)));
+    m_HessianFilter->SetInput(m_ScaleSpaceImage);
+    m_HessianFilter->SetInputSigma(m_ScaleSpaceImageSigma);
+  }
+  else
+  {
+    m_HessianFilter->SetInput(this->GetScaleSpaceInput());
+    m_HessianFilter->SetInputSigma(0.0);
+  }
+
+  /* Select the cheapest backend for this sigma, on the region of the grid the scale is computed on */
+  if (m_AutomaticConvolutionBackend)
+  {
+    const SigmaType kernelSigma =
+      std::sqrt(thisSigma * thisSigma - m_HessianFilter->GetInputSigma() * m_HessianFilter->GetInputSigma());
+    const bool forwardTransformAvailable =
+      !m_IncrementalSmoothing && !downsample && m_HessianFilter->HasForwardTransform();
+    m_HessianFilter->SetConvolutionBackend(m_CostModel->SelectBackend(kernelSigma,
+                                                                      this->GetOutputRegionOnGrid(grid).GetSize(),
+                                                                      grid->GetLargestPossibleRegion().GetSize(),
+                                                                      grid->GetSpacing(),
+                                                                      forwardTransformAvailable));
+  }
+
+  /* Connect the pipeline. The grid may differ from the one of the previous scale. The footprint of the filters
+   * upstream of the estimation sizes its pieces when it has a memory budget. Only the discrete backend streams
+   * its input, padded by the kernel radius, the other backends request all of it once and their buffers do not
+   * shrink with the pieces. */
   m_HessianFilter->SetSigma(thisSigma);
-  // m_EigenToMeasureImageFilter->GetOutput()->SetRequestedRegion(this->GetOutputRegion());
-  m_EigenToMeasureImageFilter->Update();
-  return m_EigenToMeasureImageFilter->GetOutput();
+  const bool streamedInput = m_HessianFilter->GetConvolutionBackend() == ConvolutionBackendEnum::Discrete;
+  typename EigenValueImageType::SizeType upstreamRadius;
+  upstreamRadius.Fill(0);
+  SizeValueType upstreamBytesPerPixel = sizeof(EigenValueArrayType);
+  if (streamedInput)
+  {
+    upstreamRadius = m_HessianFilter->GetKernelRadius();
+    upstreamBytesPerPixel += sizeof(InternalRealType);
+  }
+  if (m_FusedEigenAnalysis && streamedInput)
+  {
+    /* Same derivatives, computed by tiles straight into the eigenvalues */
+    m_FusedEigenAnalysisFilter->SetInput(m_HessianFilter->GetInput());
+    m_FusedEigenAnalysisFilter->SetInputSigma(m_HessianFilter->GetInputSigma());
+    m_FusedEigenAnalysisFilter->SetSigma(thisSigma);
+    m_EigenToMeasureParameterEstimationFilter->SetInput(m_FusedEigenAnalysisFilter->GetOutput());
+  }
+  else
+  {
+    upstreamBytesPerPixel += sizeof(HessianPixelType);
+    if (streamedInput)
+    {
+      /* The pass tree of the hessian holds one filtered image per dimension but the last along its deepest path */
+      upstreamBytesPerPixel += (ImageDimension - 1) * sizeof(typename HessianFilterType::InternalRealType);
+    }
+    m_EigenToMeasureParameterEstimationFilter->SetInput(m_EigenAnalysisFilter->GetOutput());
+  }
+  m_EigenToMeasureParameterEstimationFilter->SetUpstreamRadius(upstreamRadius);
+  m_EigenToMeasureParameterEstimationFilter->SetUpstreamBytesPerPixel(upstreamBytesPerPixel);
+
+  return grid;
+}
+
+template <typename TInputImage, typename TOutputImage>
+bool
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::EstimatesFromHessianInvariants() const
+{
+  /* Not with the fused eigen analysis, which never buffers the hessian, nor over two passes */
+  return m_HessianInvariantEstimation && !m_TwoPassStreaming &&
+         m_EigenToMeasureParameterEstimationFilter->GetInput() == m_EigenAnalysisFilter->GetOutput() &&
+         m_EigenToMeasureParameterEstimationFilter->CanEstimateFromHessianInvariants();
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::ParameterArrayType
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::EstimateParametersAtScale(
+  const OutputImageRegionType & region)
+{
+  if (this->EstimatesFromHessianInvariants())
+  {
+    /* Reduced piece by piece with a memory budget, otherwise buffered whole for the measure to reuse */
+    m_EigenToMeasureParameterEstimationFilter->EstimateFromHessianInvariants(m_HessianFilter->GetOutput(), region);
+  }
+  else
+  {
+    /* Only the parameters are accumulated over the pieces */
+    m_EigenToMeasureParameterEstimationFilter->GenerateOutputImageOff();
+    m_EigenToMeasureParameterEstimationFilter->GetOutput()->SetRequestedRegion(region);
+    m_EigenToMeasureParameterEstimationFilter->Update();
+  }
+  return m_EigenToMeasureParameterEstimationFilter->GetParameters();
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename TOutputImage::Pointer
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::generateResponseAtScale(SigmaType      thisSigma,
+                                                                                         TOutputImage * accumulator)
+{
+  const ImageBase<ImageDimension> * grid = this->SetUpScale(thisSigma);
+  const bool                        downsample = grid != this->GetInput();
+  const OutputImageRegionType       regionOnGrid = this->GetOutputRegionOnGrid(grid);
+
+  /* Only a measure on the output grid can be accumulated, the others are resampled first */
+  m_EigenToMeasureImageFilter->SetAccumulator(downsample ? nullptr : accumulator);
+
+  /* A single pass over the eigenvalues of the scale, which the estimation filter computes before the measure */
+  const bool singlePass =
+    m_EstimationSigmaArray.GetSize() == 0 && !m_TwoPassStreaming && !this->EstimatesFromHessianInvariants();
+
+  /* The hessian is computed again for the measure after a first pass streamed through the estimation. The hessian
+   * buffered whole for the estimation from its invariants is reused. */
+  const bool estimationPass =
+    m_EstimationSigmaArray.GetSize() == 0 &&
+    (m_TwoPassStreaming ||
+     (this->EstimatesFromHessianInvariants() && m_EigenToMeasureParameterEstimationFilter->GetMemoryBudget() > 0));
+  this->StartProgressOfScale(thisSigma, estimationPass ? 2 : 1);
+
+  typename TOutputImage::Pointer response;
+  if (singlePass && m_EigenToMeasureParameterEstimationFilter->GetMemoryBudget() > 0)
+  {
+    /* The estimation streams the eigenvalues in the pieces of its budget and assembles them in its output, which
+     * it passes through to the measure */
+    m_EigenToMeasureParameterEstimationFilter->GenerateOutputImageOn();
+    m_EigenToMeasureImageFilter->SetInput(m_EigenToMeasureParameterEstimationFilter->GetOutput());
+    m_EigenToMeasureImageFilter->SetParametersInput(m_EigenToMeasureParameterEstimationFilter->GetParametersOutput());
+    m_EigenToMeasureImageFilter->GetOutput()->SetRequestedRegion(regionOnGrid);
+    m_EigenToMeasureImageFilter->Update();
+    response = m_EigenToMeasureImageFilter->GetOutput();
+  }
+  else
+  {
+    /* The parameters are known before the measure, estimated before the scales or in a first pass over this
+     * one, and the eigenvalues are streamed straight into the measure */
+    if (singlePass)
+    {
+      /* Without a budget the eigenvalues are computed once over the whole region. The estimation and the measure
+       * then read them in place in a single piece, nothing is copied. */
+      auto * eigenValues = const_cast<EigenValueImageType *>(m_EigenToMeasureParameterEstimationFilter->GetInput());
+      eigenValues->SetRequestedRegion(regionOnGrid);
+      eigenValues->Update();
+    }
+    if (m_EstimationSigmaArray.GetSize() == 0)
+    {
+      m_ScaleParameters->Set(this->EstimateParametersAtScale(regionOnGrid));
+    }
+    if (estimationPass)
+    {
+      this->CompleteProgressPass();
+    }
+    m_EigenToMeasureImageFilter->SetInput(m_EigenToMeasureParameterEstimationFilter->GetInput());
+    response = this->StreamMeasure(regionOnGrid);
+  }
+  this->CompleteProgressPass();
+
+  if (m_EigenToMeasureImageFilter->GetAccumulator())
+  {
+    /* The output only shares the buffer of the accumulator, which holds the response */
+    m_EigenToMeasureImageFilter->SetAccumulator(nullptr);
+    m_EigenToMeasureImageFilter->GetOutput()->ReleaseData();
+    return accumulator;
+  }
+
+  /* The next scale creates a new output so this one is kept */
+  response->DisconnectPipeline();
+
+  if (downsample)
+  {
+    /* Interpolate the coarse response back onto the output grid */
+    using ResampleFilterType = ResampleImageFilter<TOutputImage, TOutputImage>;
+    using InterpolatorType = LinearInterpolateImageFunction<TOutputImage, double>;
+    using ExtrapolatorType = NearestNeighborExtrapolateImageFunction<TOutputImage, double>;
+    typename ResampleFilterType::Pointer resampleFilter = ResampleFilterType::New();
+    resampleFilter->SetInput(response);
+    resampleFilter->SetReferenceImage(this->GetInput());
+    resampleFilter->UseReferenceImageOn();
+    resampleFilter->SetInterpolator(InterpolatorType::New());
+    resampleFilter->SetExtrapolator(ExtrapolatorType::New());
+    resampleFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    resampleFilter->GetOutput()->SetRequestedRegion(m_OutputRegion);
+    resampleFilter->Update();
+
+    response = resampleFilter->GetOutput();
+    response->DisconnectPipeline();
+  }
+
+  return response;
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::ShrinkFactorsType
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GetShrinkFactors(SigmaType thisSigma) const
+{
+  ShrinkFactorsType shrinkFactors;
+  shrinkFactors.Fill(1);
+
+  if (!m_PyramidEvaluation)
+  {
+    return shrinkFactors;
+  }
+
+  const TInputImage * input = this->GetInput();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    /* Keep PyramidSamplesPerSigma samples per sigma and a few samples along every dimension */
+    const SizeValueType size = input->GetLargestPossibleRegion().GetSize(i);
+    while (2.0 * shrinkFactors[i] * input->GetSpacing()[i] * m_PyramidSamplesPerSigma <= thisSigma &&
+           size / (2 * shrinkFactors[i]) >= 8)
+    {
+      shrinkFactors[i] *= 2;
+    }
+  }
+
+  /* The automatic backend also chooses between the grids */
+  bool downsample = false;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    downsample = downsample || shrinkFactors[i] > 1;
+  }
+  if (downsample && m_AutomaticConvolutionBackend && !this->IsDownsamplingCheaper(thisSigma, shrinkFactors))
+  {
+    shrinkFactors.Fill(1);
+  }
+
+  return shrinkFactors;
+}
+
+template <typename TInputImage, typename TOutputImage>
+bool
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::IsDownsamplingCheaper(
+  SigmaType                 thisSigma,
+  const ShrinkFactorsType & shrinkFactors) const
+{
+  using SizeType = typename ScaleSpaceImageType::SizeType;
+  using SpacingType = typename ScaleSpaceImageType::SpacingType;
+
+  /* The coarse grid and the coarse pixels covering the region, see GetOutputRegionOnGrid() */
+  const TInputImage * input = this->GetInput();
+  const SizeType &    gridSize = input->GetLargestPossibleRegion().GetSize();
+  const SizeType &    size = m_OutputRegion.GetSize();
+  const SpacingType & spacing = input->GetSpacing();
+  SizeType            coarseGridSize;
+  SizeType            coarseSize;
+  SpacingType         coarseSpacing;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    coarseGridSize[i] = gridSize[i] / shrinkFactors[i];
+    coarseSize[i] = std::min(coarseGridSize[i], (size[i] + shrinkFactors[i] - 1) / shrinkFactors[i] + 1);
+    coarseSpacing[i] = spacing[i] * shrinkFactors[i];
+  }
+
+  /* Smoothing the input by half of sigma and the rest of sigma on the coarse grid, against the whole of sigma on
+   * the input grid, each with its cheapest backend. The smoothing is counted from the input, the interpolation
+   * back onto the input grid is not counted. */
+  const SigmaType coarseSigma = std::sqrt(0.75) * thisSigma;
+  const auto      fineBackend = m_CostModel->SelectBackend(thisSigma, size, gridSize, spacing);
+  const auto coarseBackend = m_CostModel->SelectBackend(coarseSigma, coarseSize, coarseGridSize, coarseSpacing);
+  const double fineCost = m_CostModel->EstimateCost(fineBackend, thisSigma, size, gridSize, spacing);
+  const double coarseCost =
+    m_CostModel->EstimateSmoothingCost(0.5 * thisSigma, gridSize, spacing) +
+    m_CostModel->EstimateCost(coarseBackend, coarseSigma, coarseSize, coarseGridSize, coarseSpacing);
+  itkDebugMacro(<< "Sigma " << thisSigma << " costs " << fineCost << " s on the input grid and " << coarseCost
+                << " s on the coarse grid");
+
+  return coarseCost < fineCost;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::UpdateScaleSpaceImage(SigmaType smoothingSigma)
+{
+  /* Start over from the input when the image is already smoother than requested */
+  if (m_ScaleSpaceImage.IsNull() || m_ScaleSpaceImageSigma > smoothingSigma)
+  {
+    const ScaleSpaceImageType * input = this->GetScaleSpaceInput();
+    if (input == m_CastFilter->GetOutput())
+    {
+      m_CastFilter->UpdateLargestPossibleRegion();
+      typename ScaleSpaceImageType::Pointer castImage = m_CastFilter->GetOutput();
+      castImage->DisconnectPipeline();
+      input = castImage;
+    }
+    m_ScaleSpaceImage = input;
+    m_ScaleSpaceImageSigma = 0.0;
+  }
+
+  if (smoothingSigma > m_ScaleSpaceImageSigma)
+  {
+    /* Gaussians compose by adding their variances, so only the difference is convolved */
+    const SigmaType incrementVariance =
+      smoothingSigma * smoothingSigma - m_ScaleSpaceImageSigma * m_ScaleSpaceImageSigma;
+
+    /* Wide enough for four standard deviations, the kernels are truncated by the maximum error anyway */
+    const typename ScaleSpaceImageType::SpacingType & spacing = m_ScaleSpaceImage->GetSpacing();
+    double                                            minimumSpacing = spacing[0];
+    for (unsigned int i = 1; i < ImageDimension; ++i)
+    {
+      minimumSpacing = std::min(minimumSpacing, spacing[i]);
+    }
+    const int maximumKernelWidth =
+      2 * static_cast<int>(std::ceil(4.0 * std::sqrt(incrementVariance) / minimumSpacing)) + 1;
+
+    using SmoothingFilterType = DiscreteGaussianImageFilter<ScaleSpaceImageType, ScaleSpaceImageType>;
+    typename SmoothingFilterType::Pointer smoothingFilter = SmoothingFilterType::New();
+    smoothingFilter->SetInput(m_ScaleSpaceImage);
+    smoothingFilter->SetVariance(incrementVariance);
+    smoothingFilter->SetMaximumError(m_HessianFilter->GetMaximumError());
+    smoothingFilter->SetMaximumKernelWidth(std::max(maximumKernelWidth, 32));
+    smoothingFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    smoothingFilter->Update();
+
+    typename ScaleSpaceImageType::Pointer smoothedImage = smoothingFilter->GetOutput();
+    smoothedImage->DisconnectPipeline();
+    m_ScaleSpaceImage = smoothedImage;
+    m_ScaleSpaceImageSigma = smoothingSigma;
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+const typename MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::ScaleSpaceImageType *
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GetScaleSpaceInput()
+{
+  /* Real inputs are read as they are, only integer inputs go through the cast */
+  if (const auto * input = dynamic_cast<const ScaleSpaceImageType *>(this->GetInput()))
+  {
+    return input;
+  }
+  m_CastFilter->SetInput(this->GetInput());
+  return m_CastFilter->GetOutput();
 }
 
 template <typename TInputImage, typename TOutputImage>
 typename MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::OutputImageRegionType
 MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GetOutputRegion()
 {
-  /* Create region */
-  OutputImageRegionType region;
-
   /* Get and test input */
-  InputImagePointer inputPtr = const_cast<TInputImage *>(this->GetInput());
-
+  const TInputImage * inputPtr = this->GetInput();
   if (!inputPtr)
   {
     itkExceptionMacro(<< "Input image must be set to run this filter.");
   }
-  region = inputPtr->GetLargestPossibleRegion();
 
   /* Grab the mask pointer */
   MaskSpatialObjectTypeConstPointer mask = this->GetImageMask();
-  if (!mask)
+  if (!m_CropToMask || !mask)
   {
     // No mask was set so we need to estimate parameters across the whole image
-    return region;
+    return inputPtr->GetLargestPossibleRegion();
+  }
+
+  /* Crop the region to the pixels inside the mask, in the index space of the input */
+  if (!m_VoxelMask->IsRasterizationOf(mask, inputPtr))
+  {
+    m_VoxelMask->Rasterize(mask, inputPtr, this->GetMultiThreader(), this->GetNumberOfWorkUnits());
+  }
+  return m_VoxelMask->GetBoundingRegion();
+}
+
+template <typename TInputImage, typename TOutputImage>
+typename MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::OutputImageRegionType
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GetOutputRegionOnGrid(
+  const ImageBase<ImageDimension> * grid) const
+{
+  const TInputImage * input = this->GetInput();
+  if (grid->GetLargestPossibleRegion() == input->GetLargestPossibleRegion() &&
+      grid->GetSpacing() == input->GetSpacing() && grid->GetOrigin() == input->GetOrigin() &&
+      grid->GetDirection() == input->GetDirection())
+  {
+    return m_OutputRegion;
+  }
+  if (m_OutputRegion == input->GetLargestPossibleRegion())
+  {
+    return grid->GetLargestPossibleRegion();
+  }
+
+  /* Bound the corners of the region, on the borders of its pixels, in the continuous index space of the grid */
+  using ContinuousIndexType = ContinuousIndex<double, ImageDimension>;
+  ContinuousIndexType lower;
+  ContinuousIndexType upper;
+  lower.Fill(NumericTraits<double>::max());
+  upper.Fill(NumericTraits<double>::NonpositiveMin());
+  for (unsigned int corner = 0; corner < (1u << ImageDimension); ++corner)
+  {
+    ContinuousIndexType index;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      index[i] = (corner >> i) & 1u ? m_OutputRegion.GetUpperIndex()[i] + 0.5 : m_OutputRegion.GetIndex(i) - 0.5;
+    }
+    typename InputImageType::PointType point;
+    input->TransformContinuousIndexToPhysicalPoint(index, point);
+    grid->TransformPhysicalPointToContinuousIndex(point, index);
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      lower[i] = std::min(lower[i], index[i]);
+      upper[i] = std::max(upper[i], index[i]);
+    }
   }
 
-  /* Crop the region */
-  typename MaskSpatialObjectType::RegionType maskRegion = mask->GetAxisAlignedBoundingBoxRegion();
-  region.Crop(maskRegion);
+  /* Linear interpolation at a continuous index reads the pixel before and the one after it */
+  typename OutputImageRegionType::IndexType lowerIndex;
+  typename OutputImageRegionType::IndexType upperIndex;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    lowerIndex[i] = Math::Floor<IndexValueType>(lower[i]);
+    upperIndex[i] = Math::Floor<IndexValueType>(upper[i]) + 1;
+  }
+  OutputImageRegionType region;
+  region.SetIndex(lowerIndex);
+  region.SetUpperIndex(upperIndex);
+  region.Crop(grid->GetLargestPossibleRegion());
 
   return region;
 }
@@ -334,6 +892,109 @@ MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GenerateLoga
     SigmaMinimum, SigmaMaximum, NumberOfSigmaSteps, Self::SigmaStepMethodEnum::LogarithmicSigmaSteps);
 }
 
+template <typename TInputImage, typename TOutputImage>
+bool
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::ReusesForwardTransform(
+  const SigmaArrayType & sigmas,
+  SigmaStepsType         first) const
+{
+  /* Incremental smoothing transforms a new image at every scale */
+  if (m_IncrementalSmoothing)
+  {
+    return false;
+  }
+
+  const TInputImage * input = this->GetInput();
+  const typename ScaleSpaceImageType::SizeType & gridSize = input->GetLargestPossibleRegion().GetSize();
+  for (SigmaStepsType scaleLevel = first; scaleLevel < sigmas.GetSize(); ++scaleLevel)
+  {
+    /* Downsampled scales transform the coarse image */
+    const ShrinkFactorsType shrinkFactors = this->GetShrinkFactors(sigmas[scaleLevel]);
+    bool                    downsample = false;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      downsample = downsample || shrinkFactors[i] > 1;
+    }
+    if (downsample)
+    {
+      continue;
+    }
+
+    /* Same choice as SetUpScale() makes while the transform is available */
+    const ConvolutionBackendEnum backend =
+      m_AutomaticConvolutionBackend
+        ? m_CostModel->SelectBackend(sigmas[scaleLevel], m_OutputRegion.GetSize(), gridSize, input->GetSpacing(), true)
+        : m_ConvolutionBackend;
+    if (backend == ConvolutionBackendEnum::FFT)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename TInputImage, typename TOutputImage>
+double
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::GetProgressShareOfScale(SigmaType thisSigma) const
+{
+  const ShrinkFactorsType shrinkFactors = this->GetShrinkFactors(thisSigma);
+  double                  share = static_cast<double>(m_OutputRegion.GetNumberOfPixels());
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    share /= shrinkFactors[i];
+  }
+  return share;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::StartProgressOfScale(
+  SigmaType    thisSigma,
+  unsigned int numberOfHessianPasses)
+{
+  m_ProgressPassWeight = this->GetProgressShareOfScale(thisSigma) / numberOfHessianPasses;
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::CompleteProgressPass()
+{
+  m_ProgressDone += m_ProgressPassWeight;
+  if (m_ProgressTotal > 0.0)
+  {
+    this->UpdateProgress(static_cast<float>(std::min(m_ProgressDone / m_ProgressTotal, 1.0)));
+  }
+
+  /* Stop between the computations of the hessian, as ProgressReporter does between pixels */
+  if (this->GetAbortGenerateData())
+  {
+    ProcessAborted e(__FILE__, __LINE__);
+    e.SetDescription("Process aborted.");
+    e.SetLocation(ITK_LOCATION);
+    throw e;
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::ReportPassProgress(Object * caller,
+                                                                                     const EventObject &)
+{
+  const auto * filter = dynamic_cast<const ProcessObject *>(caller);
+  if (!filter || m_ProgressTotal <= 0.0)
+  {
+    return;
+  }
+
+  /* A hessian streamed in pieces restarts its progress for every piece, the progress of this filter never goes back */
+  const double progress = (m_ProgressDone + m_ProgressPassWeight * filter->GetProgress()) / m_ProgressTotal;
+  if (progress > this->GetProgress())
+  {
+    this->UpdateProgress(static_cast<float>(std::min(progress, 1.0)));
+  }
+}
+
 template <typename TInputImage, typename TOutputImage>
 typename MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::InternalEigenValueOrderType
 MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::ConvertType(ExternalEigenValueOrderType order)
@@ -358,11 +1019,25 @@ MultiScaleHessianEnhancementImageFilter<TInputImage, TOutputImage>::PrintSelf(st
   Superclass::PrintSelf(os, indent);
   os << indent << "HessianFilter: " << m_HessianFilter.GetPointer() << std::endl;
   os << indent << "EigenAnalysisFilter: " << m_EigenAnalysisFilter.GetPointer() << std::endl;
+  os << indent << "FusedEigenAnalysisFilter: " << m_FusedEigenAnalysisFilter.GetPointer() << std::endl;
   os << indent << "MaximumAbsoluteValueFilter: " << m_MaximumAbsoluteValueFilter.GetPointer() << std::endl;
   os << indent << "EigenToMeasureImageFilter: " << m_EigenToMeasureImageFilter.GetPointer() << std::endl;
   os << indent << "EigenToMeasureParameterEstimationFilter: " << m_EigenToMeasureParameterEstimationFilter.GetPointer()
      << std::endl;
   os << indent << "SigmaArray: " << m_SigmaArray << std::endl;
+  os << indent << "EstimationSigmaArray: " << m_EstimationSigmaArray << std::endl;
+  os << indent << "ConvolutionBackend: " << static_cast<int>(m_ConvolutionBackend) << std::endl;
+  os << indent << "AutomaticConvolutionBackend: " << m_AutomaticConvolutionBackend << std::endl;
+  os << indent << "CostModel: " << m_CostModel.GetPointer() << std::endl;
+  os << indent << "IncrementalSmoothing: " << m_IncrementalSmoothing << std::endl;
+  os << indent << "PyramidEvaluation: " << m_PyramidEvaluation << std::endl;
+  os << indent << "PyramidSamplesPerSigma: " << m_PyramidSamplesPerSigma << std::endl;
+  os << indent << "FusedEigenAnalysis: " << m_FusedEigenAnalysis << std::endl;
+  os << indent << "HessianInvariantEstimation: " << m_HessianInvariantEstimation << std::endl;
+  os << indent << "TwoPassStreaming: " << m_TwoPassStreaming << std::endl;
+  os << indent << "ScaleParameters: " << m_ScaleParameters->Get() << std::endl;
+  os << indent << "VoxelMask: " << m_VoxelMask.GetPointer() << std::endl;
+  os << indent << "CropToMask: " << m_CropToMask << std::endl;
 }
 
 } // end namespace itk
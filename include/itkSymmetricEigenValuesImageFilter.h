@@ -0,0 +1,170 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkSymmetricEigenValuesImageFilter_h
+#define itkSymmetricEigenValuesImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkSymmetricEigenAnalysis.h"
+#include <type_traits>
+
+namespace itk
+{
+/** \class SymmetricEigenValuesImageFilter
+ * \brief Computes the eigenvalues of an image of symmetric matrices in closed form.
+ *
+ * This filter produces the same eigenvalues as SymmetricEigenAnalysisImageFilter
+ * without the eigenvectors. In 2D the eigenvalues are the roots of the
+ * characteristic quadratic. In 3D they are computed with the trigonometric
+ * solution of the characteristic cubic. Pixels are processed in batches
+ * stored component by component, and the solvers are branch free so the
+ * compiler vectorizes them across pixels: the 3D solver evaluates the arc
+ * cosine and the cosine with the polynomials of EigenToMeasureMath and
+ * selects with bit masks instead of conditionals. Both solvers take square
+ * roots, which compilers only vectorize when they may ignore errno, as with
+ * -fno-math-errno.
+ *
+ * The trigonometric solution loses accuracy when two eigenvalues are nearly
+ * equal or when the matrix is nearly a multiple of the identity. These pixels
+ * are solved again with the iterative SymmetricEigenAnalysis in double
+ * precision. All the computations are done in double precision. Other
+ * dimensions always use SymmetricEigenAnalysis.
+ *
+ * The eigenvalues are ordered as set with SetEigenValueOrder(). When they are
+ * not ordered they are returned in increasing order.
+ *
+ * \sa SymmetricEigenAnalysisImageFilter
+ * \sa MultiScaleHessianEnhancementImageFilter
+ *
+ * \ingroup BoneEnhancement
+ */
+template <typename TInputImage, typename TOutputImage>
+class ITK_TEMPLATE_EXPORT SymmetricEigenValuesImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(SymmetricEigenValuesImageFilter);
+
+  /** Standard Self typedef */
+  using Self = SymmetricEigenValuesImageFilter;
+  using Superclass = ImageToImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SymmetricEigenValuesImageFilter, ImageToImageFilter);
+
+  /** Image dimension. */
+  itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+  /** Input image typedefs. */
+  using InputImageType = TInputImage;
+  using InputImagePixelType = typename InputImageType::PixelType;
+  using InputImageRegionType = typename InputImageType::RegionType;
+
+  /** Output image typedefs. */
+  using OutputImageType = TOutputImage;
+  using OutputImagePixelType = typename OutputImageType::PixelType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using OutputValueType = typename OutputImagePixelType::ValueType;
+
+  /** Ordering of the eigenvalues. */
+  using EigenValueOrderEnum = SymmetricEigenAnalysisEnums::EigenValueOrder;
+
+  /** Set/Get the ordering of the eigenvalues. Defaults to ordering by value. */
+  itkSetEnumMacro(EigenValueOrder, EigenValueOrderEnum);
+  itkGetEnumMacro(EigenValueOrder, EigenValueOrderEnum);
+
+  /** Type the eigenvalues are computed with. */
+  using ComputeType = double;
+
+  /** Iterative solver used for the pixels the closed form cannot handle accurately. */
+  using MatrixType = Matrix<ComputeType, ImageDimension, ImageDimension>;
+  using EigenValuesArrayType = FixedArray<ComputeType, ImageDimension>;
+  using IterativeSolverType = SymmetricEigenAnalysis<MatrixType, EigenValuesArrayType, MatrixType>;
+
+  /** Number of pixels solved together. */
+  static constexpr unsigned int BatchSize = 64;
+
+  /** Number of independent components of a symmetric matrix. */
+  static constexpr unsigned int NumberOfComponents = ImageDimension * (ImageDimension + 1) / 2;
+
+  /** Solve a batch of n matrices given component by component, the
+   * components of a matrix being stored row by row in its upper triangle.
+   * The eigenvalues are returned in increasing order. */
+  static void
+  ComputeBatch(const ComputeType components[][BatchSize], ComputeType eigenValues[][BatchSize], unsigned int n);
+
+  /** Sort the eigenvalues of one matrix by increasing magnitude. */
+  static void
+  SortByMagnitude(ComputeType values[]);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro(SameDimensionCheck,
+                  (Concept::SameDimension<TInputImage::ImageDimension, TOutputImage::ImageDimension>));
+  // End concept checking
+#endif
+
+protected:
+  SymmetricEigenValuesImageFilter();
+  ~SymmetricEigenValuesImageFilter() override = default;
+
+  void
+  GenerateData() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  using DimensionTag = std::integral_constant<unsigned int, ImageDimension>;
+
+  /** Solvers of ComputeBatch() for each dimension. */
+  static void
+  ComputeBatchOfDimension(const ComputeType components[][BatchSize],
+                          ComputeType       eigenValues[][BatchSize],
+                          unsigned int      n,
+                          std::integral_constant<unsigned int, 2>);
+  static void
+  ComputeBatchOfDimension(const ComputeType components[][BatchSize],
+                          ComputeType       eigenValues[][BatchSize],
+                          unsigned int      n,
+                          std::integral_constant<unsigned int, 3>);
+  template <unsigned int VDimension>
+  static void
+  ComputeBatchOfDimension(const ComputeType components[][BatchSize],
+                          ComputeType       eigenValues[][BatchSize],
+                          unsigned int      n,
+                          std::integral_constant<unsigned int, VDimension>);
+
+  /** Solve one matrix with the iterative solver. The eigenvalues are
+   * returned in increasing order. */
+  static void
+  ComputeIteratively(const ComputeType components[][BatchSize], ComputeType eigenValues[][BatchSize], unsigned int k);
+
+private:
+  EigenValueOrderEnum m_EigenValueOrder;
+}; // end class
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkSymmetricEigenValuesImageFilter.hxx"
+#endif
+
+#endif // itkSymmetricEigenValuesImageFilter_h
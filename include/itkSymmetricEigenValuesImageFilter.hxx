@@ -0,0 +1,278 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkSymmetricEigenValuesImageFilter_hxx
+#define itkSymmetricEigenValuesImageFilter_hxx
+
+#include "itkImageScanlineIterator.h"
+#include "itkEigenToMeasureMath.h"
+#include "itkMath.h"
+#include <cmath>
+
+namespace itk
+{
+template <typename TInputImage, typename TOutputImage>
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::SymmetricEigenValuesImageFilter()
+  : m_EigenValueOrder(EigenValueOrderEnum::OrderByValue)
+{}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::GenerateData()
+{
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType *      outputPtr = this->GetOutput();
+
+  this->AllocateOutputs();
+
+  const bool orderByMagnitude = (m_EigenValueOrder == EigenValueOrderEnum::OrderByMagnitude);
+
+  MultiThreaderBase::Pointer mt = this->GetMultiThreader();
+
+  mt->ParallelizeImageRegion<ImageDimension>(
+    outputPtr->GetRequestedRegion(),
+    [inputPtr, outputPtr, orderByMagnitude](const OutputImageRegionType & region) {
+      /* Batches stored component by component */
+      ComputeType components[NumberOfComponents][BatchSize];
+      ComputeType eigenValues[ImageDimension][BatchSize];
+
+      ImageScanlineConstIterator<InputImageType> inputIt(inputPtr, region);
+      ImageScanlineIterator<OutputImageType>     outputIt(outputPtr, region);
+
+      while (!inputIt.IsAtEnd())
+      {
+        while (!inputIt.IsAtEndOfLine())
+        {
+          unsigned int n = 0;
+          for (; n < BatchSize && !inputIt.IsAtEndOfLine(); ++n, ++inputIt)
+          {
+            const InputImagePixelType tensor = inputIt.Get();
+            for (unsigned int c = 0; c < NumberOfComponents; ++c)
+            {
+              components[c][n] = static_cast<ComputeType>(tensor[c]);
+            }
+          }
+
+          Self::ComputeBatch(components, eigenValues, n);
+
+          for (unsigned int k = 0; k < n; ++k, ++outputIt)
+          {
+            ComputeType values[ImageDimension];
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              values[i] = eigenValues[i][k];
+            }
+
+            /* The solvers return increasing values, sort by magnitude if requested */
+            if (orderByMagnitude)
+            {
+              Self::SortByMagnitude(values);
+            }
+
+            OutputImagePixelType pixel;
+            for (unsigned int i = 0; i < ImageDimension; ++i)
+            {
+              pixel[i] = static_cast<OutputValueType>(values[i]);
+            }
+            outputIt.Set(pixel);
+          }
+        }
+
+        inputIt.NextLine();
+        outputIt.NextLine();
+      }
+    },
+    nullptr);
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::ComputeBatch(const ComputeType components[][BatchSize],
+                                                                         ComputeType       eigenValues[][BatchSize],
+                                                                         unsigned int      n)
+{
+  Self::ComputeBatchOfDimension(components, eigenValues, n, DimensionTag());
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::SortByMagnitude(ComputeType values[])
+{
+  for (unsigned int i = 1; i < ImageDimension; ++i)
+  {
+    const ComputeType value = values[i];
+    unsigned int      j = i;
+    for (; j > 0 && std::abs(values[j - 1]) > std::abs(value); --j)
+    {
+      values[j] = values[j - 1];
+    }
+    values[j] = value;
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::ComputeBatchOfDimension(
+  const ComputeType components[][BatchSize],
+  ComputeType       eigenValues[][BatchSize],
+  unsigned int      n,
+  std::integral_constant<unsigned int, 2>)
+{
+  const ComputeType * a00 = components[0];
+  const ComputeType * a01 = components[1];
+  const ComputeType * a11 = components[2];
+  ComputeType *       e0 = eigenValues[0];
+  ComputeType *       e1 = eigenValues[1];
+
+  for (unsigned int k = 0; k < n; ++k)
+  {
+    const ComputeType mean = 0.5 * (a00[k] + a11[k]);
+    const ComputeType half = 0.5 * (a00[k] - a11[k]);
+    const ComputeType radius = std::sqrt(half * half + a01[k] * a01[k]);
+    e0[k] = mean - radius;
+    e1[k] = mean + radius;
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::ComputeBatchOfDimension(
+  const ComputeType components[][BatchSize],
+  ComputeType       eigenValues[][BatchSize],
+  unsigned int      n,
+  std::integral_constant<unsigned int, 3>)
+{
+  const ComputeType * a00 = components[0];
+  const ComputeType * a01 = components[1];
+  const ComputeType * a02 = components[2];
+  const ComputeType * a11 = components[3];
+  const ComputeType * a12 = components[4];
+  const ComputeType * a22 = components[5];
+  ComputeType *       e0 = eigenValues[0];
+  ComputeType *       e1 = eigenValues[1];
+  ComputeType *       e2 = eigenValues[2];
+
+  /* Below these tolerances the trigonometric solution loses about half of the
+   * digits of the double precision: the distance of the cosine of the angle to
+   * one for a pair of nearly equal eigenvalues, and the spread of the
+   * eigenvalues relative to their mean for a nearly isotropic matrix. */
+  constexpr ComputeType rootTolerance = 1e-6;
+  constexpr ComputeType spreadTolerance = 1e-6;
+  constexpr ComputeType twoThirdsPi = 2.0 * Math::pi / 3.0;
+
+  /* Conditions are bit masks so the loop is vectorized, see EigenToMeasureMath::NegativeMask() */
+  using EigenToMeasureMath::NegativeMask;
+  using EigenToMeasureMath::Select;
+  std::uint64_t fallback[BatchSize];
+
+  for (unsigned int k = 0; k < n; ++k)
+  {
+    /* Shift by the mean and scale the matrix B = (A - qI) / p to unit spread */
+    const ComputeType q = (a00[k] + a11[k] + a22[k]) / 3.0;
+    const ComputeType d0 = a00[k] - q;
+    const ComputeType d1 = a11[k] - q;
+    const ComputeType d2 = a22[k] - q;
+    const ComputeType offDiagonal = a01[k] * a01[k] + a02[k] * a02[k] + a12[k] * a12[k];
+    const ComputeType   p = std::sqrt((d0 * d0 + d1 * d1 + d2 * d2 + 2.0 * offDiagonal) / 6.0);
+    const std::uint64_t positiveP = NegativeMask(0.0 - p);
+    const ComputeType   inverseP = Select(positiveP, 1.0 / p, 0.0);
+
+    /* The eigenvalues of B are 2 cos(phi + 2 pi j / 3) where cos(3 phi) = det(B) / 2 */
+    const ComputeType determinant = d0 * (d1 * d2 - a12[k] * a12[k]) - a01[k] * (a01[k] * d2 - a12[k] * a02[k]) +
+                                    a02[k] * (a01[k] * a12[k] - d1 * a02[k]);
+    ComputeType r = 0.5 * determinant * inverseP * inverseP * inverseP;
+    r = Select(NegativeMask(r + 1.0), -1.0, r);
+    r = Select(NegativeMask(1.0 - r), 1.0, r);
+    const ComputeType phi = EigenToMeasureMath::Acos(r) / 3.0;
+
+    const ComputeType largest = q + 2.0 * p * EigenToMeasureMath::Cos(phi);
+    const ComputeType smallest = q + 2.0 * p * EigenToMeasureMath::Cos(phi + twoThirdsPi);
+    e0[k] = smallest;
+    e1[k] = 3.0 * q - largest - smallest;
+    e2[k] = largest;
+
+    fallback[k] = positiveP & (NegativeMask((1.0 - std::abs(r)) - rootTolerance) |
+                               NegativeMask(p - spreadTolerance * std::abs(q)));
+  }
+
+  for (unsigned int k = 0; k < n; ++k)
+  {
+    if (fallback[k] != 0)
+    {
+      Self::ComputeIteratively(components, eigenValues, k);
+    }
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <unsigned int VDimension>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::ComputeBatchOfDimension(
+  const ComputeType components[][BatchSize],
+  ComputeType       eigenValues[][BatchSize],
+  unsigned int      n,
+  std::integral_constant<unsigned int, VDimension>)
+{
+  for (unsigned int k = 0; k < n; ++k)
+  {
+    Self::ComputeIteratively(components, eigenValues, k);
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::ComputeIteratively(
+  const ComputeType components[][BatchSize],
+  ComputeType       eigenValues[][BatchSize],
+  unsigned int      k)
+{
+  /* Components are stored row by row in the upper triangle of the matrix */
+  MatrixType   matrix;
+  unsigned int c = 0;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = i; j < ImageDimension; ++j, ++c)
+    {
+      matrix(i, j) = components[c][k];
+      matrix(j, i) = components[c][k];
+    }
+  }
+
+  IterativeSolverType solver(ImageDimension);
+  solver.SetOrderEigenValues(true);
+
+  EigenValuesArrayType values;
+  solver.ComputeEigenValues(matrix, values);
+
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    eigenValues[i][k] = values[i];
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SymmetricEigenValuesImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "EigenValueOrder: " << static_cast<int>(m_EigenValueOrder) << std::endl;
+}
+
+} // end namespace itk
+
+#endif // itkSymmetricEigenValuesImageFilter_hxx
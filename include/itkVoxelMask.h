@@ -0,0 +1,229 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkVoxelMask_h
+#define itkVoxelMask_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageBase.h"
+#include "itkMultiThreaderBase.h"
+#include "itkSpatialObject.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace itk
+{
+/** \class VoxelMask
+ * \brief Mask spatial object rasterized once on the grid of an image.
+ *
+ * Testing whether a pixel is inside a SpatialObject requires transforming its
+ * index to a physical point and asking the spatial object, which is costly
+ * for meshes and polygons. Rasterize() evaluates the spatial object once at
+ * the center of every pixel of an image and stores the result as one bit per
+ * pixel. IsInside() is then a lookup by index.
+ *
+ * Every scanline starts on a new 64 bit word, so scanlines are rasterized in
+ * parallel and are contiguous in memory. The mask applies to the images with
+ * the same origin, spacing and direction whose largest possible region lies
+ * in the rasterized region, which IsOnGridOf() checks.
+ *
+ * The mask is also run-length encoded as the runs of consecutive pixels
+ * inside it on every scanline. VisitRuns() lets filters process the runs of a
+ * scanline as contiguous arrays of pixels, skipping the pixels outside
+ * without testing them one by one, which pays off for masks covering a small
+ * part of the image.
+ *
+ * \sa EigenToMeasureImageFilter
+ * \sa EigenToMeasureParameterEstimationFilter
+ * \sa MultiScaleHessianEnhancementImageFilter
+ *
+ * \ingroup BoneEnhancement
+ */
+template <unsigned int VDimension>
+class ITK_TEMPLATE_EXPORT VoxelMask : public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_MOVE(VoxelMask);
+
+  /** Standard Self typedef */
+  using Self = VoxelMask;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VoxelMask, Object);
+
+  /** Image dimension. */
+  itkStaticConstMacro(ImageDimension, unsigned int, VDimension);
+
+  /** Grid typedefs. */
+  using ImageBaseType = ImageBase<VDimension>;
+  using IndexType = typename ImageBaseType::IndexType;
+  using SizeType = typename ImageBaseType::SizeType;
+  using RegionType = typename ImageBaseType::RegionType;
+  using PointType = typename ImageBaseType::PointType;
+  using SpacingType = typename ImageBaseType::SpacingType;
+  using DirectionType = typename ImageBaseType::DirectionType;
+
+  /** Mask typedefs. */
+  using MaskSpatialObjectType = SpatialObject<VDimension>;
+
+  /** Word holding the bits of 64 consecutive pixels of a scanline */
+  using WordType = std::uint64_t;
+
+  /** Run of consecutive pixels of a scanline inside the mask, starting at
+   * index Start along the first dimension */
+  struct RunType
+  {
+    IndexValueType Start;
+    SizeValueType  Length;
+  };
+
+  /** Set every pixel of the largest possible region of the image inside
+   * which the spatial object is. The scanlines are rasterized in parallel by
+   * the multi-threader, typically that of the filter owning the mask, with
+   * the given number of work units when not 0. A multi-threader is created
+   * when none is given. */
+  void
+  Rasterize(const MaskSpatialObjectType * mask,
+            const ImageBaseType *         image,
+            MultiThreaderBase *           multiThreader = nullptr,
+            ThreadIdType                  numberOfWorkUnits = 0);
+
+  /** Whether the mask was rasterized from this spatial object, not modified
+   * since, on the grid and largest possible region of this image. */
+  bool
+  IsRasterizationOf(const MaskSpatialObjectType * mask, const ImageBaseType * image) const;
+
+  /** Whether the mask applies to the pixels of the image. */
+  bool
+  IsOnGridOf(const ImageBaseType * image) const;
+
+  /** Whether the pixel is inside the mask. Pixels outside of the rasterized
+   * region are not. */
+  bool
+  IsInside(const IndexType & index) const
+  {
+    if (!m_Region.IsInside(index))
+    {
+      return false;
+    }
+    const SizeValueType x = static_cast<SizeValueType>(index[0] - m_Region.GetIndex(0));
+    const WordType      word = m_Words[this->ComputeLineNumber(index) * m_WordsPerLine + x / 64];
+    return (word >> (x % 64)) & 1u;
+  }
+
+  /** Call function(start, length) for every run inside the mask of the length
+   * pixels of a scanline starting at index, in increasing order, clipped to
+   * these pixels. Scanlines outside of the rasterized region have no run. */
+  template <typename TFunction>
+  void
+  VisitRuns(const IndexType & index, SizeValueType length, TFunction && function) const
+  {
+    IndexType lineIndex = index;
+    lineIndex[0] = m_Region.GetIndex(0);
+    if (length == 0 || !m_Region.IsInside(lineIndex))
+    {
+      return;
+    }
+    const SizeValueType  line = this->ComputeLineNumber(lineIndex);
+    const IndexValueType begin = index[0];
+    const IndexValueType end = begin + static_cast<IndexValueType>(length);
+    for (SizeValueType r = m_RunOffsets[line]; r < m_RunOffsets[line + 1]; ++r)
+    {
+      const IndexValueType runBegin = std::max(m_Runs[r].Start, begin);
+      const IndexValueType runEnd = std::min(m_Runs[r].Start + static_cast<IndexValueType>(m_Runs[r].Length), end);
+      if (runBegin < runEnd)
+      {
+        function(runBegin, static_cast<SizeValueType>(runEnd - runBegin));
+      }
+    }
+  }
+
+  /** Get the rasterized region. */
+  itkGetConstReferenceMacro(Region, RegionType);
+
+  /** Get the number of pixels inside the mask. */
+  itkGetConstMacro(NumberOfPixelsInside, SizeValueType);
+
+  /** Get the smallest region holding every pixel inside the mask, of size
+   * zero when no pixel is. */
+  itkGetConstReferenceMacro(BoundingRegion, RegionType);
+
+  /** Get the number of runs of pixels inside the mask. */
+  SizeValueType
+  GetNumberOfRuns() const
+  {
+    return m_Runs.size();
+  }
+
+protected:
+  VoxelMask();
+  ~VoxelMask() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Number of the scanline of an index inside the region */
+  SizeValueType
+  ComputeLineNumber(const IndexType & index) const
+  {
+    SizeValueType line = 0;
+    for (unsigned int i = VDimension - 1; i > 0; --i)
+    {
+      line = line * m_Region.GetSize(i) + static_cast<SizeValueType>(index[i] - m_Region.GetIndex(i));
+    }
+    return line;
+  }
+
+  /** Encode the runs of every scanline from the bits and bound them */
+  void
+  EncodeRuns();
+
+private:
+  RegionType            m_Region;
+  RegionType            m_BoundingRegion;
+  PointType             m_Origin;
+  SpacingType           m_Spacing;
+  DirectionType         m_Direction;
+  SizeValueType         m_WordsPerLine;
+  SizeValueType         m_NumberOfPixelsInside;
+  std::vector<WordType> m_Words;
+
+  /** Runs of every scanline, those of scanline l being in
+   * [m_RunOffsets[l], m_RunOffsets[l + 1]) */
+  std::vector<RunType>       m_Runs;
+  std::vector<SizeValueType> m_RunOffsets;
+
+  /** Spatial object rasterized, only compared to, and its modification time then */
+  const MaskSpatialObjectType * m_Mask;
+  ModifiedTimeType              m_MaskMTime;
+}; // end class
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkVoxelMask.hxx"
+#endif
+
+#endif // itkVoxelMask_h
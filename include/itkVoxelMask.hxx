@@ -0,0 +1,215 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkVoxelMask_hxx
+#define itkVoxelMask_hxx
+
+#include "itkIndexRange.h"
+#include <atomic>
+
+namespace itk
+{
+template <unsigned int VDimension>
+VoxelMask<VDimension>::VoxelMask()
+  : m_WordsPerLine(0)
+  , m_NumberOfPixelsInside(0)
+  , m_Mask(nullptr)
+  , m_MaskMTime(0)
+{
+  m_Origin.Fill(0.0);
+  m_Spacing.Fill(1.0);
+  m_Direction.SetIdentity();
+}
+
+template <unsigned int VDimension>
+void
+VoxelMask<VDimension>::Rasterize(const MaskSpatialObjectType * mask,
+                                 const ImageBaseType *         image,
+                                 MultiThreaderBase *           multiThreader,
+                                 ThreadIdType                  numberOfWorkUnits)
+{
+  if (!mask || !image)
+  {
+    itkExceptionMacro(<< "A spatial object and an image are required to rasterize a mask.");
+  }
+
+  m_Region = image->GetLargestPossibleRegion();
+  m_Origin = image->GetOrigin();
+  m_Spacing = image->GetSpacing();
+  m_Direction = image->GetDirection();
+  m_Mask = mask;
+  m_MaskMTime = mask->GetMTime();
+
+  const SizeValueType lineLength = m_Region.GetSize(0);
+  const SizeValueType numberOfLines = lineLength > 0 ? m_Region.GetNumberOfPixels() / lineLength : 0;
+  m_WordsPerLine = (lineLength + 63) / 64;
+  m_Words.assign(numberOfLines * m_WordsPerLine, 0);
+
+  std::atomic<SizeValueType> numberOfPixelsInside(0);
+
+  /* Pieces hold whole scanlines, so no word is written by two threads */
+  MultiThreaderBase::Pointer mt = multiThreader;
+  if (mt.IsNull())
+  {
+    mt = MultiThreaderBase::New();
+  }
+  if (numberOfWorkUnits > 0)
+  {
+    mt->SetNumberOfWorkUnits(numberOfWorkUnits);
+  }
+  mt->ParallelizeImageRegionRestrictDirection<VDimension>(
+    0,
+    m_Region,
+    [this, mask, image, &numberOfPixelsInside](const RegionType & region) {
+      PointType     point;
+      SizeValueType inside = 0;
+      for (const IndexType & index : ImageRegionIndexRange<VDimension>(region))
+      {
+        image->TransformIndexToPhysicalPoint(index, point);
+        if (mask->IsInsideInObjectSpace(point))
+        {
+          const SizeValueType x = static_cast<SizeValueType>(index[0] - m_Region.GetIndex(0));
+          m_Words[this->ComputeLineNumber(index) * m_WordsPerLine + x / 64] |= WordType{ 1 } << (x % 64);
+          ++inside;
+        }
+      }
+      numberOfPixelsInside += inside;
+    },
+    nullptr);
+
+  m_NumberOfPixelsInside = numberOfPixelsInside;
+  this->EncodeRuns();
+  this->Modified();
+}
+
+template <unsigned int VDimension>
+void
+VoxelMask<VDimension>::EncodeRuns()
+{
+  const SizeValueType lineLength = m_Region.GetSize(0);
+  const SizeValueType numberOfLines = m_WordsPerLine > 0 ? m_Words.size() / m_WordsPerLine : 0;
+
+  m_Runs.clear();
+  m_RunOffsets.assign(numberOfLines + 1, 0);
+
+  IndexType lower = m_Region.GetUpperIndex();
+  IndexType upper = m_Region.GetIndex();
+  IndexType lineIndex = m_Region.GetIndex();
+
+  /* A run starts at a set bit following a clear one and ends at the next
+   * clear bit. Words without any change are skipped whole, the bits past the
+   * end of a scanline are clear. */
+  for (SizeValueType line = 0; line < numberOfLines; ++line)
+  {
+    const WordType * words = m_Words.data() + line * m_WordsPerLine;
+    bool             inside = false;
+    SizeValueType    start = 0;
+    for (SizeValueType w = 0; w < m_WordsPerLine; ++w)
+    {
+      const WordType word = words[w];
+      if (word == (inside ? ~WordType{ 0 } : WordType{ 0 }))
+      {
+        continue;
+      }
+      for (SizeValueType b = 0; b < 64; ++b)
+      {
+        if (((word >> b) & 1u) != inside)
+        {
+          const SizeValueType x = w * 64 + b;
+          if (inside)
+          {
+            m_Runs.push_back(RunType{ m_Region.GetIndex(0) + static_cast<IndexValueType>(start), x - start });
+          }
+          start = x;
+          inside = !inside;
+        }
+      }
+    }
+    if (inside)
+    {
+      m_Runs.push_back(RunType{ m_Region.GetIndex(0) + static_cast<IndexValueType>(start), lineLength - start });
+    }
+    m_RunOffsets[line + 1] = m_Runs.size();
+
+    /* Bound the runs of the scanline, which are in increasing order */
+    if (m_RunOffsets[line + 1] > m_RunOffsets[line])
+    {
+      const RunType & first = m_Runs[m_RunOffsets[line]];
+      const RunType & last = m_Runs.back();
+      lineIndex[0] = first.Start;
+      for (unsigned int i = 0; i < VDimension; ++i)
+      {
+        lower[i] = std::min(lower[i], lineIndex[i]);
+        upper[i] = std::max(upper[i], lineIndex[i]);
+      }
+      upper[0] = std::max(upper[0], last.Start + static_cast<IndexValueType>(last.Length) - 1);
+    }
+
+    /* Next scanline */
+    for (unsigned int i = 1; i < VDimension; ++i)
+    {
+      if (++lineIndex[i] <= m_Region.GetUpperIndex()[i])
+      {
+        break;
+      }
+      lineIndex[i] = m_Region.GetIndex(i);
+    }
+  }
+
+  m_BoundingRegion = RegionType(m_Region.GetIndex(), SizeType());
+  if (!m_Runs.empty())
+  {
+    m_BoundingRegion.SetIndex(lower);
+    m_BoundingRegion.SetUpperIndex(upper);
+  }
+}
+
+template <unsigned int VDimension>
+bool
+VoxelMask<VDimension>::IsRasterizationOf(const MaskSpatialObjectType * mask, const ImageBaseType * image) const
+{
+  return mask && image && mask == m_Mask && mask->GetMTime() <= m_MaskMTime &&
+         image->GetLargestPossibleRegion() == m_Region && this->IsOnGridOf(image);
+}
+
+template <unsigned int VDimension>
+bool
+VoxelMask<VDimension>::IsOnGridOf(const ImageBaseType * image) const
+{
+  /* The grids come from the same image, so they are compared exactly */
+  return m_Mask && image && image->GetOrigin() == m_Origin && image->GetSpacing() == m_Spacing &&
+         image->GetDirection() == m_Direction && m_Region.IsInside(image->GetLargestPossibleRegion());
+}
+
+template <unsigned int VDimension>
+void
+VoxelMask<VDimension>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Region: " << m_Region << std::endl;
+  os << indent << "BoundingRegion: " << m_BoundingRegion << std::endl;
+  os << indent << "Origin: " << m_Origin << std::endl;
+  os << indent << "Spacing: " << m_Spacing << std::endl;
+  os << indent << "Direction: " << m_Direction << std::endl;
+  os << indent << "NumberOfPixelsInside: " << m_NumberOfPixelsInside << std::endl;
+  os << indent << "NumberOfRuns: " << m_Runs.size() << std::endl;
+}
+
+} // end namespace itk
+
+#endif // itkVoxelMask_hxx
@@ -17,6 +17,10 @@ itk_module(BoneEnhancement
     ITKStatistics
     ITKImageFilterBase
     ITKImageFeature
+    ITKImageGrid
+    ITKImageFunction
+    ITKFFT
+    ITKSmoothing
     ITKSpatialObjects
   COMPILE_DEPENDS
     ITKImageSources
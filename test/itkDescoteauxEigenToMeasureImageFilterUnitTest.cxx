@@ -172,6 +172,9 @@ TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, InitialParameters)
   EXPECT_DOUBLE_EQ(-1.0, this->m_Filter->GetEnhanceType());
 
   EXPECT_EQ(2, static_cast<int>(this->m_Filter->GetEigenValueOrder()));
+
+  /* Default exact measure */
+  EXPECT_TRUE(this->m_Filter->GetApproximationLevel() == TestFixture::FilterType::ApproximationLevelEnum::Exact);
 }
 
 TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, TestZerosImage)
@@ -217,6 +220,28 @@ TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, TestRealEigenPixelBri
   }
 }
 
+TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, TestFastApproximationBrightSheet)
+{
+  this->m_Parameters[0] = 0.5;
+  this->m_Parameters[1] = 0.5;
+  this->m_Parameters[2] = 0.25;
+  this->m_Filter->SetParameters(this->m_Parameters);
+  this->m_Filter->SetInput(this->m_NonZeroEigenImage);
+  this->m_Filter->SetApproximationLevel(TestFixture::FilterType::ApproximationLevelEnum::Fast);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_TRUE(this->m_Filter->GetOutput()->GetBufferedRegion() == this->m_Region);
+
+  using ImageType = typename itk::Image<TypeParam, 3>;
+  itk::ImageRegionIteratorWithIndex<ImageType> input(this->m_Filter->GetOutput(), this->m_Region);
+
+  input.GoToBegin();
+  while (!input.IsAtEnd())
+  {
+    ASSERT_NEAR((TypeParam)0.0913983433747, input.Get(), 1e-6);
+    ++input;
+  }
+}
+
 TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, TestRealEigenPixelDarkSheet)
 {
   this->m_Parameters[0] = 0.5;
@@ -314,3 +339,45 @@ TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, TestWithSpatialObject
     ++input;
   }
 }
+
+TYPED_TEST(itkDescoteauxEigenToMeasureImageFilterUnitTest, TestAccumulator)
+{
+  this->m_Parameters[0] = 0.5;
+  this->m_Parameters[1] = 0.5;
+  this->m_Parameters[2] = 0.25;
+  this->m_Filter->SetParameters(this->m_Parameters);
+  this->m_Filter->SetInput(this->m_NonZeroEigenImage);
+
+  /* Accumulated values on either side of the measure, in absolute value and sign */
+  using ImageType = typename itk::Image<TypeParam, 3>;
+  typename ImageType::Pointer accumulator = ImageType::New();
+  accumulator->SetRegions(this->m_Region);
+  accumulator->Allocate();
+  itk::ImageRegionIteratorWithIndex<ImageType> accumulatorIt(accumulator, this->m_Region);
+  for (accumulatorIt.GoToBegin(); !accumulatorIt.IsAtEnd(); ++accumulatorIt)
+  {
+    accumulatorIt.Set(static_cast<TypeParam>(0.02 * (accumulatorIt.GetIndex()[0] - 5)));
+  }
+
+  this->m_Filter->SetAccumulator(accumulator);
+  EXPECT_EQ(accumulator.GetPointer(), this->m_Filter->GetAccumulator());
+  EXPECT_NO_THROW(this->m_Filter->Update());
+
+  /* The output was written over the accumulator */
+  EXPECT_EQ(accumulator->GetBufferPointer(), this->m_Filter->GetOutput()->GetBufferPointer());
+  for (accumulatorIt.GoToBegin(); !accumulatorIt.IsAtEnd(); ++accumulatorIt)
+  {
+    const TypeParam expected =
+      accumulatorIt.GetIndex()[0] == 0 ? static_cast<TypeParam>(-0.1) : static_cast<TypeParam>(0.0913983433747);
+    ASSERT_NEAR(expected, accumulatorIt.Get(), 1e-6);
+  }
+
+  /* The accumulator must hold the requested region */
+  typename ImageType::RegionType smallerRegion = this->m_Region;
+  smallerRegion.ShrinkByRadius(1);
+  typename ImageType::Pointer smallerAccumulator = ImageType::New();
+  smallerAccumulator->SetRegions(smallerRegion);
+  smallerAccumulator->Allocate();
+  this->m_Filter->SetAccumulator(smallerAccumulator);
+  EXPECT_THROW(this->m_Filter->Update(), itk::ExceptionObject);
+}
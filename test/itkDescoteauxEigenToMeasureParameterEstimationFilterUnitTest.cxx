@@ -18,6 +18,7 @@
 
 #include "itkGTest.h"
 #include "itkDescoteauxEigenToMeasureParameterEstimationFilter.h"
+#include "itkChangeInformationImageFilter.h"
 #include "itkImageMaskSpatialObject.h"
 #include "itkImage.h"
 #include "itkImageRegionIteratorWithIndex.h"
@@ -228,6 +229,104 @@ TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, TestOne
   EXPECT_NEAR(0.17320508075, this->m_Parameters[2], 1e-6); // sqrt(3) * 0.1
 }
 
+TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, TestPassThrough)
+{
+  /* Streamed in pieces, the output is a copy */
+  using ChangeInformationFilterType = itk::ChangeInformationImageFilter<typename TestFixture::EigenImageType>;
+  auto upstream = ChangeInformationFilterType::New();
+  upstream->SetInput(this->m_MaskingEigenImage);
+  this->m_Filter->SetInput(upstream->GetOutput());
+  this->m_Filter->SetNumberOfStreamDivisions(4);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(4u, this->m_Filter->GetNumberOfPieces());
+  EXPECT_TRUE(this->m_Filter->GetOutput()->GetBufferedRegion() == this->m_Region);
+  EXPECT_NE(this->m_MaskingEigenImage->GetBufferPointer(), this->m_Filter->GetOutput()->GetBufferPointer());
+  const typename TestFixture::ParameterArrayType streamedParameters = this->m_Filter->GetParameters();
+
+  using EigenValueArrayType = itk::FixedArray<TypeParam, 3>;
+  using ImageType = typename itk::Image<EigenValueArrayType, 3>;
+  itk::ImageRegionIteratorWithIndex<ImageType> output(this->m_Filter->GetOutput(), this->m_Region);
+  for (output.GoToBegin(); !output.IsAtEnd(); ++output)
+  {
+    ASSERT_TRUE(this->m_MaskingEigenImage->GetPixel(output.GetIndex()) == output.Get());
+  }
+
+  /* An input already buffered is processed in one piece, whose buffer the output shares */
+  this->m_Filter->SetInput(this->m_MaskingEigenImage);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(1u, this->m_Filter->GetNumberOfPieces());
+  EXPECT_TRUE(this->m_Filter->GetOutput()->GetBufferedRegion() == this->m_Region);
+  EXPECT_EQ(this->m_MaskingEigenImage->GetBufferPointer(), this->m_Filter->GetOutput()->GetBufferPointer());
+
+  this->m_Parameters = this->m_Filter->GetParameters();
+  EXPECT_DOUBLE_EQ(streamedParameters[2], this->m_Parameters[2]);
+}
+
+TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, TestWithoutOutputImage)
+{
+  using ChangeInformationFilterType = itk::ChangeInformationImageFilter<typename TestFixture::EigenImageType>;
+  auto upstream = ChangeInformationFilterType::New();
+  upstream->SetInput(this->m_MaskingEigenImage);
+  this->m_Filter->SetInput(upstream->GetOutput());
+  this->m_Filter->SetNumberOfStreamDivisions(4);
+  EXPECT_TRUE(this->m_Filter->GetGenerateOutputImage());
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  const typename TestFixture::ParameterArrayType expected = this->m_Filter->GetParameters();
+
+  /* Only the parameters are computed, from every piece */
+  this->m_Filter->GenerateOutputImageOff();
+  EXPECT_FALSE(this->m_Filter->GetGenerateOutputImage());
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(4u, this->m_Filter->GetNumberOfPieces());
+  EXPECT_EQ(0u, this->m_Filter->GetOutput()->GetBufferedRegion().GetNumberOfPixels());
+
+  this->m_Parameters = this->m_Filter->GetParameters();
+  for (unsigned int i = 0; i < expected.GetSize(); ++i)
+  {
+    EXPECT_EQ(expected[i], this->m_Parameters[i]);
+  }
+}
+
+TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, TestMemoryBudget)
+{
+  using ChangeInformationFilterType = itk::ChangeInformationImageFilter<typename TestFixture::EigenImageType>;
+  auto upstream = ChangeInformationFilterType::New();
+  upstream->SetInput(this->m_MaskingEigenImage);
+  this->m_Filter->SetInput(upstream->GetOutput());
+
+  /* Two slices of 10 x 10 pixels per piece */
+  const itk::SizeValueType bytesPerPixel = sizeof(typename TestFixture::EigenValueArrayType);
+  this->m_Filter->SetMemoryBudget(2 * 100 * bytesPerPixel);
+  EXPECT_EQ(2 * 100 * bytesPerPixel, this->m_Filter->GetMemoryBudget());
+  EXPECT_EQ(bytesPerPixel, this->m_Filter->GetUpstreamBytesPerPixel());
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(5u, this->m_Filter->GetNumberOfPieces());
+  const typename TestFixture::ParameterArrayType streamedParameters = this->m_Filter->GetParameters();
+
+  /* A halo of one pixel leaves two slices of 12 x 12 pixels out of four */
+  typename TestFixture::EigenImageType::SizeType radius;
+  radius.Fill(1);
+  this->m_Filter->SetUpstreamRadius(radius);
+  this->m_Filter->SetMemoryBudget(4 * 144 * bytesPerPixel);
+  upstream->Modified();
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(5u, this->m_Filter->GetNumberOfPieces());
+
+  /* Enough for the whole input and its halo */
+  this->m_Filter->SetMemoryBudget(12 * 144 * bytesPerPixel);
+  upstream->Modified();
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(1u, this->m_Filter->GetNumberOfPieces());
+
+  /* The input is up to date, it is not streamed again whatever the budget */
+  this->m_Filter->SetMemoryBudget(bytesPerPixel);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  EXPECT_EQ(1u, this->m_Filter->GetNumberOfPieces());
+
+  this->m_Parameters = this->m_Filter->GetParameters();
+  EXPECT_EQ(streamedParameters[2], this->m_Parameters[2]);
+}
+
 TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, DISABLED_TestWithSpatialObject)
 {
   this->m_Filter->SetInput(this->m_MaskingEigenImage);
@@ -240,3 +339,62 @@ TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, DISABLE
   EXPECT_DOUBLE_EQ(0.5, this->m_Parameters[1]);
   EXPECT_NEAR(86.6025403784, this->m_Parameters[2], 1e-6); // sqrt(3) * 0.1
 }
+
+TYPED_TEST(itkDescoteauxEigenToMeasureParameterEstimationFilterUnitTest, TestHessianInvariants)
+{
+  /* Random hessian and its eigenvalues */
+  using EigenImageType = typename TestFixture::EigenImageType;
+  using FilterType = typename TestFixture::FilterType;
+  using HessianImageType = typename FilterType::HessianImageType;
+  auto hessian = HessianImageType::New();
+  hessian->SetRegions(this->m_Region);
+  hessian->Allocate();
+
+  unsigned int                                        seed = 1;
+  itk::ImageRegionIteratorWithIndex<HessianImageType> hessianIt(hessian, this->m_Region);
+  itk::ImageRegionIteratorWithIndex<EigenImageType>   input(this->m_MaskingEigenImage, this->m_Region);
+  for (; !hessianIt.IsAtEnd(); ++hessianIt, ++input)
+  {
+    typename HessianImageType::PixelType tensor;
+    for (unsigned int i = 0; i < tensor.Size(); ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      tensor[i] = static_cast<double>(seed >> 8) / 65536.0 - 128;
+    }
+    typename HessianImageType::PixelType::EigenValuesArrayType eigenValues;
+    tensor.ComputeEigenValues(eigenValues);
+    typename TestFixture::EigenValueArrayType pixel;
+    for (unsigned int i = 0; i < pixel.Length; ++i)
+    {
+      pixel[i] = static_cast<TypeParam>(eigenValues[i]);
+    }
+    hessianIt.Set(tensor);
+    input.Set(pixel);
+  }
+
+  this->m_Filter->SetInput(this->m_MaskingEigenImage);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  const typename TestFixture::ParameterArrayType expected = this->m_Filter->GetParameters();
+
+  /* The Frobenius norm of the eigenvalues is that of the hessian */
+  EXPECT_TRUE(this->m_Filter->CanEstimateFromHessianInvariants());
+  EXPECT_NO_THROW(this->m_Filter->EstimateFromHessianInvariants(hessian, this->m_Region));
+  this->m_Parameters = this->m_Filter->GetParameters();
+  EXPECT_DOUBLE_EQ(expected[0], this->m_Parameters[0]);
+  EXPECT_DOUBLE_EQ(expected[1], this->m_Parameters[1]);
+  EXPECT_NEAR(expected[2], this->m_Parameters[2], 1e-4 * expected[2]);
+
+  /* Only buffered regions of the hessian */
+  typename EigenImageType::RegionType outside = this->m_Region;
+  outside.PadByRadius(1);
+  EXPECT_THROW(this->m_Filter->EstimateFromHessianInvariants(hessian, outside), itk::ExceptionObject);
+
+  /* A computed hessian is reduced in the pieces of the memory budget, to the same maximum */
+  using HessianSourceType = itk::ChangeInformationImageFilter<HessianImageType>;
+  auto hessianSource = HessianSourceType::New();
+  hessianSource->SetInput(hessian);
+  this->m_Filter->SetMemoryBudget(3 * 10 * 10 * sizeof(typename TestFixture::EigenValueArrayType));
+  EXPECT_NO_THROW(this->m_Filter->EstimateFromHessianInvariants(hessianSource->GetOutput(), this->m_Region));
+  EXPECT_GT(this->m_Filter->GetNumberOfPieces(), 1u);
+  EXPECT_DOUBLE_EQ(this->m_Parameters[2], this->m_Filter->GetParameters()[2]);
+}
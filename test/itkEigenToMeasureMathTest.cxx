@@ -0,0 +1,192 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkEigenToMeasureMath.h"
+#include "itkKrcahEigenToMeasureImageFilter.h"
+#include "itkDescoteauxEigenToMeasureImageFilter.h"
+#include "itkFixedArray.h"
+#include "itkTestingMacros.h"
+#include "itkMath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+using EigenValueType = itk::FixedArray<float, 3>;
+
+/* Eigenvalues ordered by magnitude drawn by a linear congruential generator,
+ * with the degenerate pixels the measures exclude */
+std::vector<EigenValueType>
+MakeEigenValues(unsigned int count)
+{
+  std::vector<EigenValueType> values(count);
+  unsigned int                seed = 1;
+  for (auto & value : values)
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      value[i] = static_cast<float>(seed >> 8) / 16777216.0f * 4.0f - 2.0f;
+    }
+    std::sort(value.Begin(), value.End(), [](float a, float b) { return std::abs(a) < std::abs(b); });
+  }
+  values[0].Fill(0.0f);
+  values[1][2] = 0.0f;
+  values[2][1] = 0.0f;
+  return values;
+}
+
+/* Compare the single precision measures of a functor to the double precision ones */
+template <template <typename, typename, typename> class TFunctor>
+int
+CompareFastToExact(double a, double b, double c, double enhanceType, const std::vector<EigenValueType> & values)
+{
+  const TFunctor<EigenValueType, double, double> exactFunctor(a, b, c, enhanceType);
+  const TFunctor<EigenValueType, float, float>   fastFunctor(a, b, c, enhanceType);
+
+  std::vector<float> measures(values.size());
+  fastFunctor.Evaluate(values.data(), measures.data(), values.size());
+
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    const double expected = exactFunctor(values[i]);
+    if (itk::Math::abs(measures[i] - expected) > 1e-6 || itk::Math::abs(fastFunctor(values[i]) - expected) > 1e-6)
+    {
+      std::cerr << "Fast measure " << measures[i] << " differs from " << expected << " for eigenvalues " << values[i]
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+/* Compare the batch evaluation of a functor to its evaluation pixel by pixel */
+template <typename TFunctor>
+int
+CompareBatchToPixelwise(const TFunctor & functor, const std::vector<EigenValueType> & values, const char * name)
+{
+  std::vector<double> measures(values.size());
+  functor.Evaluate(values.data(), measures.data(), values.size());
+
+  for (std::size_t i = 0; i < values.size(); ++i)
+  {
+    const double expected = functor(values[i]);
+    if (itk::Math::abs(measures[i] - expected) > 2e-15)
+    {
+      std::cerr << name << " batch measure " << measures[i] << " differs from " << expected << " for eigenvalues "
+                << values[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+} // namespace
+
+int
+itkEigenToMeasureMathTest(int, char *[])
+{
+  /* The arc cosine is within 3 ULP of std::acos over its domain */
+  for (int i = -100000; i <= 100000; ++i)
+  {
+    const double x = i / 100000.0;
+    const double expected = std::acos(x);
+    const double computed = itk::EigenToMeasureMath::Acos(x);
+    if (itk::Math::FloatDifferenceULP(computed, expected) > 3 || itk::Math::FloatDifferenceULP(computed, expected) < -3)
+    {
+      std::cerr << "Acos(" << x << ") = " << computed << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  ITK_TEST_EXPECT_EQUAL(0.0, itk::EigenToMeasureMath::Acos(1.0));
+  ITK_TEST_EXPECT_EQUAL(itk::Math::pi, itk::EigenToMeasureMath::Acos(-1.0));
+
+  /* The cosine is within 5e-16 of std::cos over [-pi, pi] */
+  for (int i = -100000; i <= 100000; ++i)
+  {
+    const double x = itk::Math::pi * i / 100000.0;
+    const double expected = std::cos(x);
+    const double computed = itk::EigenToMeasureMath::Cos(x);
+    if (std::abs(computed - expected) > 5e-16)
+    {
+      std::cerr << "Cos(" << x << ") = " << computed << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  ITK_TEST_EXPECT_EQUAL(1.0, itk::EigenToMeasureMath::Cos(0.0));
+  ITK_TEST_EXPECT_EQUAL(-1.0, itk::EigenToMeasureMath::Cos(itk::Math::pi));
+
+  /* The exponential is within 2 ULP of std::exp over its domain */
+  for (double x = -708.0; x < 709.0; x += 0.0137)
+  {
+    const double expected = std::exp(x);
+    const double computed = itk::EigenToMeasureMath::Exp(x);
+    if (itk::Math::FloatDifferenceULP(computed, expected) > 2 || itk::Math::FloatDifferenceULP(computed, expected) < -2)
+    {
+      std::cerr << "Exp(" << x << ") = " << computed << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  ITK_TEST_EXPECT_EQUAL(1.0, itk::EigenToMeasureMath::Exp(0.0));
+  ITK_TEST_EXPECT_EQUAL(0.0, itk::EigenToMeasureMath::Exp(-1000.0));
+  ITK_TEST_EXPECT_EQUAL(0.0, itk::EigenToMeasureMath::Exp(-std::numeric_limits<double>::infinity()));
+  ITK_TEST_EXPECT_EQUAL(itk::EigenToMeasureMath::Exp(709.0), itk::EigenToMeasureMath::Exp(1000.0));
+
+  /* The single precision exponential is within 2 ULP over its domain */
+  for (int i = -1970; i < 6420; ++i)
+  {
+    const float x = 0.0137f * static_cast<float>(i);
+    const float expected = static_cast<float>(std::exp(static_cast<double>(x)));
+    const float computed = itk::EigenToMeasureMath::Exp(x);
+    if (itk::Math::FloatDifferenceULP(computed, expected) > 2 || itk::Math::FloatDifferenceULP(computed, expected) < -2)
+    {
+      std::cerr << "Exp(" << x << "f) = " << computed << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  ITK_TEST_EXPECT_EQUAL(1.0f, itk::EigenToMeasureMath::Exp(0.0f));
+  ITK_TEST_EXPECT_EQUAL(0.0f, itk::EigenToMeasureMath::Exp(-28.0f));
+
+  ITK_TEST_EXPECT_EQUAL(2.0, itk::EigenToMeasureMath::Select(itk::EigenToMeasureMath::NegativeMask(-1.0), 2.0, 3.0));
+  ITK_TEST_EXPECT_EQUAL(3.0, itk::EigenToMeasureMath::Select(itk::EigenToMeasureMath::NegativeMask(1.0), 2.0, 3.0));
+
+  /* The batch measures match the measures computed pixel by pixel, for a
+   * count which is not a multiple of the batch size */
+  const std::vector<EigenValueType> values = MakeEigenValues(1000);
+  using KrcahFunctorType = itk::Functor::KrcahEigenToMeasure<EigenValueType, double>;
+  using DescoteauxFunctorType = itk::Functor::DescoteauxEigenToMeasure<EigenValueType, double>;
+  if (CompareBatchToPixelwise(KrcahFunctorType(0.5, 0.5, 0.25, -1.0), values, "Krcah") == EXIT_FAILURE ||
+      CompareBatchToPixelwise(KrcahFunctorType(0.5, 0.5, 0.25, 1.0), values, "Krcah") == EXIT_FAILURE ||
+      CompareBatchToPixelwise(DescoteauxFunctorType(0.5, 0.5, 0.5, -1.0), values, "Descoteaux") == EXIT_FAILURE ||
+      CompareBatchToPixelwise(DescoteauxFunctorType(0.5, 0.5, 0.5, 1.0), values, "Descoteaux") == EXIT_FAILURE)
+  {
+    return EXIT_FAILURE;
+  }
+
+  /* The single precision measures are within 1e-6 of the double precision ones */
+  if (CompareFastToExact<itk::Functor::KrcahEigenToMeasure>(0.5, 0.5, 0.25, -1.0, values) == EXIT_FAILURE ||
+      CompareFastToExact<itk::Functor::KrcahEigenToMeasure>(0.1, 0.1, 3.0, 1.0, values) == EXIT_FAILURE ||
+      CompareFastToExact<itk::Functor::DescoteauxEigenToMeasure>(0.5, 0.5, 0.5, -1.0, values) == EXIT_FAILURE ||
+      CompareFastToExact<itk::Functor::DescoteauxEigenToMeasure>(0.1, 2.0, 0.05, 1.0, values) == EXIT_FAILURE)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
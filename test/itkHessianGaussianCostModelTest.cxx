@@ -0,0 +1,171 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkHessianGaussianCostModel.h"
+#include "itkMath.h"
+#include "itkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+#include <fstream>
+
+int
+itkHessianGaussianCostModelTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv) << " calibrationFile" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  constexpr unsigned int Dimension = 2;
+  using PixelType = float;
+  using ImageType = itk::Image<PixelType, Dimension>;
+  using CostModelType = itk::HessianGaussianCostModel<ImageType>;
+  using BackendType = CostModelType::ConvolutionBackendEnum;
+
+  itksys::SystemTools::RemoveFile(argv[1]);
+
+  CostModelType::Pointer costModel = CostModelType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(costModel, HessianGaussianCostModel, Object);
+
+  /* The calibration is kept per user by default */
+  ITK_TEST_SET_GET_VALUE(CostModelType::GetDefaultCalibrationFileName(),
+                         std::string(costModel->GetCalibrationFileName()));
+
+  costModel->SetCalibrationFileName(argv[1]);
+  ITK_TEST_SET_GET_VALUE(std::string(argv[1]), std::string(costModel->GetCalibrationFileName()));
+  costModel->SetNumberOfWorkUnits(1);
+  ITK_TEST_SET_GET_VALUE(1u, costModel->GetNumberOfWorkUnits());
+  costModel->SetCalibrationImageSize(32);
+  ITK_TEST_SET_GET_VALUE(32u, costModel->GetCalibrationImageSize());
+
+  ImageType::SizeType size;
+  size.Fill(128);
+  ImageType::SpacingType spacing;
+  spacing.Fill(1.0);
+
+  /* Selecting requires a calibration */
+  ITK_TEST_EXPECT_TRUE(!costModel->IsCalibrated());
+  ITK_TRY_EXPECT_EXCEPTION(costModel->SelectBackend(1.0, size, spacing));
+
+  /* A known calibration, so the model is checked without timing anything. The line in the former format without
+   * the overheads is ignored. Discrete has the lowest overhead, FFT the lowest coefficient. */
+  const BackendType backends[] = { BackendType::Discrete, BackendType::Recursive, BackendType::FFT };
+  const double      overheads[] = { 1e-5, 1e-3, 1e-2 };
+  const double      coefficients[] = { 4e-9, 2e-7, 1e-9 };
+  {
+    std::ofstream file(argv[1]);
+    file << "# dimension workUnits overhead coefficient per backend" << std::endl;
+    file << "2 1 1 1 1" << std::endl;
+    file << "2 1";
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      file << " " << overheads[i] << " " << coefficients[i];
+    }
+    file << std::endl;
+  }
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(costModel->Calibrate());
+  ITK_TEST_EXPECT_TRUE(costModel->IsCalibrated());
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    ITK_TEST_EXPECT_EQUAL(overheads[i], costModel->GetOverhead(backends[i]));
+    ITK_TEST_EXPECT_EQUAL(coefficients[i], costModel->GetCoefficient(backends[i]));
+  }
+
+  /* The recursive backend costs its overhead plus its coefficient per pixel, whatever the sigma */
+  const double numberOfPixels = 128.0 * 128.0;
+  const double recursiveCost = costModel->EstimateCost(BackendType::Recursive, 1.0, size, spacing);
+  ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(overheads[1] + coefficients[1] * numberOfPixels, recursiveCost));
+  ITK_TEST_EXPECT_EQUAL(costModel->EstimateCost(BackendType::Recursive, 2.0, size, spacing),
+                        costModel->EstimateCost(BackendType::Recursive, 1.0, size, spacing));
+
+  /* The cost of the discrete kernels grows with sigma */
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateCost(BackendType::Discrete, 2.0, size, spacing) >
+                       costModel->EstimateCost(BackendType::Discrete, 1.0, size, spacing));
+
+  /* Reusing the forward transform makes the FFT cheaper, but never cheaper than its overhead */
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateCost(BackendType::FFT, 2.0, size, spacing, true) <
+                       costModel->EstimateCost(BackendType::FFT, 2.0, size, spacing, false));
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateCost(BackendType::FFT, 2.0, size, spacing, true) > overheads[2]);
+
+  /* On a region of the grid the discrete and recursive backends compute the region, the FFT transforms the grid */
+  ImageType::SizeType regionSize;
+  regionSize.Fill(32);
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateCost(BackendType::Discrete, 2.0, regionSize, size, spacing) <
+                       costModel->EstimateCost(BackendType::Discrete, 2.0, size, spacing));
+  ITK_TEST_EXPECT_EQUAL(costModel->EstimateCost(BackendType::Recursive, 2.0, regionSize, size, spacing),
+                        costModel->EstimateCost(BackendType::Recursive, 2.0, regionSize, spacing));
+  ITK_TEST_EXPECT_EQUAL(costModel->EstimateCost(BackendType::FFT, 2.0, regionSize, size, spacing),
+                        costModel->EstimateCost(BackendType::FFT, 2.0, size, spacing));
+
+  /* Smoothing is one discrete pass per dimension, cheaper than the passes of the hessian */
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateSmoothingCost(2.0, size, spacing) > overheads[0]);
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateSmoothingCost(2.0, size, spacing) <
+                       costModel->EstimateCost(BackendType::Discrete, 2.0, size, spacing));
+  ITK_TEST_EXPECT_TRUE(costModel->EstimateSmoothingCost(2.0, size, spacing) >
+                       costModel->EstimateSmoothingCost(1.0, size, spacing));
+
+  /* The overhead decides on a tiny image, the work on a large one with wide kernels */
+  ImageType::SizeType tinySize;
+  tinySize.Fill(4);
+  ITK_TEST_EXPECT_TRUE(costModel->SelectBackend(1.0, tinySize, spacing) == BackendType::Discrete);
+  ImageType::SizeType largeSize;
+  largeSize.Fill(1024);
+  ITK_TEST_EXPECT_TRUE(costModel->SelectBackend(8.0, largeSize, spacing) == BackendType::FFT);
+
+  /* The selected backend has the lowest cost */
+  for (double sigma = 0.5; sigma < 8.0; sigma *= 2.0)
+  {
+    const BackendType selected = costModel->SelectBackend(sigma, size, spacing);
+    for (const auto backend : backends)
+    {
+      ITK_TEST_EXPECT_TRUE(costModel->EstimateCost(selected, sigma, size, spacing) <=
+                           costModel->EstimateCost(backend, sigma, size, spacing));
+    }
+  }
+
+  /* Without a calibration for the number of work units it is measured at two sizes and two sigmas and appended to
+   * the file. Only the shape of the result is checked, the run times depend on the machine. */
+  costModel->SetNumberOfWorkUnits(2);
+  ITK_TEST_EXPECT_TRUE(!costModel->IsCalibrated());
+  ITK_TRY_EXPECT_NO_EXCEPTION(costModel->Calibrate());
+  ITK_TEST_EXPECT_TRUE(costModel->IsCalibrated());
+  for (const auto backend : backends)
+  {
+    ITK_TEST_EXPECT_TRUE(costModel->GetOverhead(backend) >= 0.0);
+    ITK_TEST_EXPECT_TRUE(costModel->GetCoefficient(backend) >= 0.0);
+  }
+
+  /* A second model reads the measured calibration from the file */
+  CostModelType::Pointer readCostModel = CostModelType::New();
+  readCostModel->SetCalibrationFileName(argv[1]);
+  readCostModel->SetNumberOfWorkUnits(2);
+  ITK_TRY_EXPECT_NO_EXCEPTION(readCostModel->Calibrate());
+  for (const auto backend : backends)
+  {
+    ITK_TEST_EXPECT_EQUAL(costModel->GetOverhead(backend), readCostModel->GetOverhead(backend));
+    ITK_TEST_EXPECT_EQUAL(costModel->GetCoefficient(backend), readCostModel->GetCoefficient(backend));
+  }
+
+  /* Changing the number of work units requires a new calibration */
+  readCostModel->SetNumberOfWorkUnits(3);
+  ITK_TEST_EXPECT_TRUE(!readCostModel->IsCalibrated());
+
+  return EXIT_SUCCESS;
+}
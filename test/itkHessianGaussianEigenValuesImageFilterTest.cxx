@@ -0,0 +1,132 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkHessianGaussianEigenValuesImageFilter.h"
+#include "itkHessianGaussianImageFilter.h"
+#include "itkSymmetricEigenValuesImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTestingMacros.h"
+#include "itkMath.h"
+
+namespace
+{
+/* Compare the fused filter against the hessian followed by the eigen analysis */
+template <unsigned int VDimension>
+int
+CompareToSeparateFilters(double sigma, double inputSigma, unsigned int tileSize)
+{
+  using ImageType = itk::Image<float, VDimension>;
+  using EigenValueImageType = itk::Image<itk::Vector<float, VDimension>, VDimension>;
+  using FusedFilterType = itk::HessianGaussianEigenValuesImageFilter<ImageType, EigenValueImageType>;
+  using HessianFilterType = itk::HessianGaussianImageFilter<ImageType>;
+  using EigenFilterType =
+    itk::SymmetricEigenValuesImageFilter<typename HessianFilterType::OutputImageType, EigenValueImageType>;
+
+  /* Random image with an anisotropic spacing, sizes not multiple of the tile size */
+  typename ImageType::SizeType    size;
+  typename ImageType::SpacingType spacing;
+  for (unsigned int i = 0; i < VDimension; ++i)
+  {
+    size[i] = 17 + 4 * i;
+    spacing[i] = 1.0 + 0.25 * i;
+  }
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions(typename ImageType::RegionType(size));
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  unsigned int                        seed = 1;
+  itk::ImageRegionIterator<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    seed = 1664525u * seed + 1013904223u;
+    it.Set(static_cast<float>(seed >> 16) / 65536.0f);
+  }
+
+  typename HessianFilterType::Pointer hessianFilter = HessianFilterType::New();
+  hessianFilter->SetInput(image);
+  hessianFilter->SetSigma(sigma);
+  hessianFilter->SetInputSigma(inputSigma);
+  hessianFilter->NormalizeAcrossScaleOn();
+
+  typename EigenFilterType::Pointer eigenFilter = EigenFilterType::New();
+  eigenFilter->SetInput(hessianFilter->GetOutput());
+  eigenFilter->SetEigenValueOrder(EigenFilterType::EigenValueOrderEnum::OrderByMagnitude);
+  ITK_TRY_EXPECT_NO_EXCEPTION(eigenFilter->Update());
+
+  typename FusedFilterType::SizeType tile;
+  tile.Fill(tileSize);
+
+  typename FusedFilterType::Pointer fusedFilter = FusedFilterType::New();
+  fusedFilter->SetInput(image);
+  fusedFilter->SetSigma(sigma);
+  fusedFilter->SetInputSigma(inputSigma);
+  fusedFilter->NormalizeAcrossScaleOn();
+  fusedFilter->SetEigenValueOrder(FusedFilterType::EigenValueOrderEnum::OrderByMagnitude);
+  fusedFilter->SetTileSize(tile);
+  ITK_TEST_SET_GET_VALUE(tile, fusedFilter->GetTileSize());
+  ITK_TRY_EXPECT_NO_EXCEPTION(fusedFilter->Update());
+
+  const typename ImageType::RegionType               region = image->GetLargestPossibleRegion();
+  itk::ImageRegionConstIterator<EigenValueImageType> expectedIt(eigenFilter->GetOutput(), region);
+  itk::ImageRegionConstIterator<EigenValueImageType> fusedIt(fusedFilter->GetOutput(), region);
+  for (; !expectedIt.IsAtEnd(); ++expectedIt, ++fusedIt)
+  {
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      if (itk::Math::abs(fusedIt.Get()[i] - expectedIt.Get()[i]) > 1e-4 * (1.0 + itk::Math::abs(expectedIt.Get()[i])))
+      {
+        std::cerr << "Eigenvalues " << fusedIt.Get() << " differ from " << expectedIt.Get() << " at "
+                  << fusedIt.GetIndex() << " for sigma " << sigma << " and tile size " << tileSize << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+} // namespace
+
+int
+itkHessianGaussianEigenValuesImageFilterTest(int, char *[])
+{
+  using ImageType = itk::Image<float, 3>;
+  using EigenValueImageType = itk::Image<itk::Vector<float, 3>, 3>;
+  using FilterType = itk::HessianGaussianEigenValuesImageFilter<ImageType, EigenValueImageType>;
+
+  FilterType::Pointer filter = FilterType::New();
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, HessianGaussianEigenValuesImageFilter, ImageToImageFilter);
+
+  ITK_TEST_SET_GET_VALUE(1.0, filter->GetSigma());
+  ITK_TEST_SET_GET_VALUE(0.0, filter->GetInputSigma());
+  ITK_TEST_SET_GET_VALUE(false, filter->GetNormalizeAcrossScale());
+  ITK_TEST_EXPECT_TRUE(filter->GetEigenValueOrder() == FilterType::EigenValueOrderEnum::OrderByValue);
+  ITK_TEST_SET_GET_VALUE(32u, static_cast<unsigned int>(filter->GetTileSize()[0]));
+
+  /* Tiles smaller than the image, wider than it, and smaller than the kernel radius */
+  if (CompareToSeparateFilters<3>(1.0, 0.0, 8) == EXIT_FAILURE ||
+      CompareToSeparateFilters<3>(2.0, 1.0, 32) == EXIT_FAILURE ||
+      CompareToSeparateFilters<3>(2.0, 0.0, 3) == EXIT_FAILURE ||
+      CompareToSeparateFilters<2>(1.5, 0.0, 5) == EXIT_FAILURE)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -48,5 +48,118 @@ itkHessianGaussianImageFilterTest(int argc, char * argv[])
   hess_filter->NormalizeAcrossScaleOn();
   ITK_TEST_SET_GET_VALUE(true, hess_filter->GetNormalizeAcrossScale());
 
+  ITK_TEST_EXPECT_TRUE(hess_filter->GetConvolutionBackend() ==
+                       HessianGaussianImageFilterType::ConvolutionBackendEnum::Discrete);
+
+  /* The Hessian of f(x,y) = x^2 + 3xy is constant. Away from the boundary the
+   * Gaussian derivatives reproduce it. */
+  ImageType::SizeType size;
+  size.Fill(40);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(size));
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    it.Set(index[0] * index[0] + 3 * index[0] * index[1]);
+  }
+
+  using HessianImageType = HessianGaussianImageFilterType::OutputImageType;
+  HessianImageType::RegionType interior = image->GetLargestPossibleRegion();
+  interior.ShrinkByRadius(12);
+
+  using BackendType = HessianGaussianImageFilterType::ConvolutionBackendEnum;
+  const BackendType backends[] = { BackendType::Discrete, BackendType::Recursive, BackendType::FFT };
+  const double      tolerances[] = { 1e-3, 5e-2, 1e-1 };
+
+  for (unsigned int b = 0; b < 3; ++b)
+  {
+    std::cout << "Testing backend " << static_cast<int>(backends[b]) << std::endl;
+    hess_filter->SetInput(image);
+    hess_filter->SetSigma(1.0);
+    hess_filter->NormalizeAcrossScaleOff();
+    hess_filter->SetConvolutionBackend(backends[b]);
+    ITK_TEST_EXPECT_TRUE(hess_filter->GetConvolutionBackend() == backends[b]);
+    ITK_TRY_EXPECT_NO_EXCEPTION(hess_filter->Update());
+
+    itk::ImageRegionIteratorWithIndex<HessianImageType> ht(hess_filter->GetOutput(), interior);
+    for (ht.GoToBegin(); !ht.IsAtEnd(); ++ht)
+    {
+      const HessianImageType::PixelType hessian = ht.Get();
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 0) - 2.0) < tolerances[b]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 1) - 3.0) < tolerances[b]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(1, 1)) < tolerances[b]);
+    }
+  }
+
+  // A second sigma reuses the forward transform of the FFT backend
+  hess_filter->SetPaddingSigma(2.0);
+  ITK_TEST_SET_GET_VALUE(2.0, hess_filter->GetPaddingSigma());
+  ITK_TRY_EXPECT_NO_EXCEPTION(hess_filter->Update());
+  hess_filter->SetSigma(2.0);
+  ITK_TRY_EXPECT_NO_EXCEPTION(hess_filter->Update());
+
+  itk::ImageRegionIteratorWithIndex<HessianImageType> ht(hess_filter->GetOutput(), interior);
+  for (ht.GoToBegin(); !ht.IsAtEnd(); ++ht)
+  {
+    const HessianImageType::PixelType hessian = ht.Get();
+    ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 0) - 2.0) < 1e-1);
+    ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 1) - 3.0) < 1e-1);
+    ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(1, 1)) < 1e-1);
+  }
+  hess_filter->ReleaseForwardTransform();
+
+  // With a spacing of 0.5 the same samples are f(x,y) = 4x^2 + 12xy. All
+  // backends give the Hessian in physical units, with the same kernels in
+  // pixels as above for a sigma of 0.5.
+  ImageType::SpacingType spacing;
+  spacing.Fill(0.5);
+  image->SetSpacing(spacing);
+  hess_filter->SetPaddingSigma(0.0);
+  for (unsigned int b = 0; b < 3; ++b)
+  {
+    std::cout << "Testing backend " << static_cast<int>(backends[b]) << " with spacing " << spacing << std::endl;
+    hess_filter->SetSigma(0.5);
+    hess_filter->SetConvolutionBackend(backends[b]);
+    ITK_TRY_EXPECT_NO_EXCEPTION(hess_filter->Update());
+
+    itk::ImageRegionIteratorWithIndex<HessianImageType> st(hess_filter->GetOutput(), interior);
+    for (st.GoToBegin(); !st.IsAtEnd(); ++st)
+    {
+      const HessianImageType::PixelType hessian = st.Get();
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 0) - 8.0) < 4.0 * tolerances[b]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 1) - 12.0) < 4.0 * tolerances[b]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(1, 1)) < 4.0 * tolerances[b]);
+    }
+  }
+  hess_filter->ReleaseForwardTransform();
+
+  // With an anisotropic spacing of (0.5, 1) the same samples are
+  // f(x,y) = 4x^2 + 6xy. Every backend gives the same Hessian in physical
+  // units, with kernels of a sigma of 2 and 1 pixels.
+  spacing[0] = 0.5;
+  spacing[1] = 1.0;
+  image->SetSpacing(spacing);
+  hess_filter->SetPaddingSigma(1.0);
+  for (unsigned int b = 0; b < 3; ++b)
+  {
+    std::cout << "Testing backend " << static_cast<int>(backends[b]) << " with spacing " << spacing << std::endl;
+    hess_filter->SetSigma(1.0);
+    hess_filter->SetConvolutionBackend(backends[b]);
+    ITK_TRY_EXPECT_NO_EXCEPTION(hess_filter->Update());
+
+    itk::ImageRegionIteratorWithIndex<HessianImageType> st(hess_filter->GetOutput(), interior);
+    for (st.GoToBegin(); !st.IsAtEnd(); ++st)
+    {
+      const HessianImageType::PixelType hessian = st.Get();
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 0) - 8.0) < 4.0 * tolerances[b]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(0, 1) - 6.0) < 4.0 * tolerances[b]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::abs(hessian(1, 1)) < 4.0 * tolerances[b]);
+    }
+  }
+  hess_filter->ReleaseForwardTransform();
+
   return EXIT_SUCCESS;
 }
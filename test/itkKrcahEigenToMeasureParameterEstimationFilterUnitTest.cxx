@@ -276,3 +276,178 @@ TYPED_TEST(itkKrcahEigenToMeasureParameterEstimationFilterUnitTest, DISABLED_Tes
   EXPECT_DOUBLE_EQ(0.5, this->m_Parameters[1]);
   EXPECT_NEAR(75.0, this->m_Parameters[2], 1e-6); // 0.25 *  300
 }
+
+TYPED_TEST(itkKrcahEigenToMeasureParameterEstimationFilterUnitTest, TestIndependentOfWorkUnits)
+{
+  /* Random eigenvalues, whose sum depends on the order of the additions */
+  using EigenImageType = typename TestFixture::EigenImageType;
+  unsigned int                                      seed = 1;
+  itk::ImageRegionIteratorWithIndex<EigenImageType> input(this->m_MaskingEigenImage, this->m_Region);
+  for (input.GoToBegin(); !input.IsAtEnd(); ++input)
+  {
+    typename TestFixture::EigenValueArrayType pixel;
+    for (unsigned int i = 0; i < pixel.Length; ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      pixel[i] = static_cast<TypeParam>(seed >> 8) / static_cast<TypeParam>(65536.0) - 128;
+    }
+    input.Set(pixel);
+  }
+
+  this->m_Filter->SetInput(this->m_MaskingEigenImage);
+  this->m_Filter->SetNumberOfWorkUnits(1);
+  this->m_Filter->SetNumberOfStreamDivisions(1);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  const typename TestFixture::ParameterArrayType expected = this->m_Filter->GetParameters();
+
+  this->m_Filter->SetNumberOfWorkUnits(7);
+  this->m_Filter->SetNumberOfStreamDivisions(3);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  this->m_Parameters = this->m_Filter->GetParameters();
+  for (unsigned int i = 0; i < expected.GetSize(); ++i)
+  {
+    EXPECT_EQ(expected[i], this->m_Parameters[i]);
+  }
+}
+
+TYPED_TEST(itkKrcahEigenToMeasureParameterEstimationFilterUnitTest, TestIndependentOfWorkUnitsWithLargeSlices)
+{
+  /* Two slices split into blocks of rows, shared by the work units */
+  using EigenImageType = typename TestFixture::EigenImageType;
+  typename EigenImageType::SizeType size;
+  size[0] = 150;
+  size[1] = 250;
+  size[2] = 2;
+  typename EigenImageType::Pointer image = EigenImageType::New();
+  image->SetRegions(typename EigenImageType::RegionType(size));
+  image->Allocate();
+
+  unsigned int                                      seed = 1;
+  itk::ImageRegionIteratorWithIndex<EigenImageType> input(image, image->GetLargestPossibleRegion());
+  for (input.GoToBegin(); !input.IsAtEnd(); ++input)
+  {
+    typename TestFixture::EigenValueArrayType pixel;
+    for (unsigned int i = 0; i < pixel.Length; ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      pixel[i] = static_cast<TypeParam>(seed >> 8) / static_cast<TypeParam>(65536.0) - 128;
+    }
+    input.Set(pixel);
+  }
+
+  this->m_Filter->SetInput(image);
+  this->m_Filter->SetNumberOfWorkUnits(1);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  const typename TestFixture::ParameterArrayType expected = this->m_Filter->GetParameters();
+
+  for (const unsigned int numberOfWorkUnits : { 2u, 3u, 8u })
+  {
+    this->m_Filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+    EXPECT_NO_THROW(this->m_Filter->Update());
+    this->m_Parameters = this->m_Filter->GetParameters();
+    for (unsigned int i = 0; i < expected.GetSize(); ++i)
+    {
+      EXPECT_EQ(expected[i], this->m_Parameters[i]);
+    }
+  }
+}
+
+TYPED_TEST(itkKrcahEigenToMeasureParameterEstimationFilterUnitTest, TestSampledEstimation)
+{
+  /* Random eigenvalues on a larger image */
+  using EigenImageType = typename TestFixture::EigenImageType;
+  typename EigenImageType::SizeType size;
+  size.Fill(48);
+  auto image = EigenImageType::New();
+  image->SetRegions(typename EigenImageType::RegionType(size));
+  image->Allocate();
+
+  unsigned int                                      seed = 1;
+  itk::ImageRegionIteratorWithIndex<EigenImageType> input(image, image->GetLargestPossibleRegion());
+  for (input.GoToBegin(); !input.IsAtEnd(); ++input)
+  {
+    typename TestFixture::EigenValueArrayType pixel;
+    for (unsigned int i = 0; i < pixel.Length; ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      pixel[i] = static_cast<TypeParam>(seed >> 8) / static_cast<TypeParam>(65536.0) - 128;
+    }
+    input.Set(pixel);
+  }
+
+  /* Every pixel, the parameters are exact */
+  this->m_Filter->SetInput(image);
+  EXPECT_DOUBLE_EQ(0.0, this->m_Filter->GetTargetRelativeError());
+  EXPECT_DOUBLE_EQ(0.95, this->m_Filter->GetConfidenceLevel());
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  const typename TestFixture::ParameterArrayType expected = this->m_Filter->GetParameters();
+  for (unsigned int i = 0; i < expected.GetSize(); ++i)
+  {
+    EXPECT_EQ(0.0, this->m_Filter->GetParametersHalfWidth()[i]);
+  }
+
+  /* A sample meets the target error, within its confidence interval */
+  this->m_Filter->SetTargetRelativeError(0.01);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  this->m_Parameters = this->m_Filter->GetParameters();
+  const typename TestFixture::ParameterArrayType halfWidths = this->m_Filter->GetParametersHalfWidth();
+  EXPECT_EQ(expected[0], this->m_Parameters[0]);
+  EXPECT_EQ(expected[1], this->m_Parameters[1]);
+  EXPECT_EQ(0.0, halfWidths[0]);
+  EXPECT_EQ(0.0, halfWidths[1]);
+  EXPECT_GT(halfWidths[2], 0.0);
+  EXPECT_LT(halfWidths[2], 0.015 * expected[2]);
+  EXPECT_NEAR(expected[2], this->m_Parameters[2], halfWidths[2]);
+}
+
+TYPED_TEST(itkKrcahEigenToMeasureParameterEstimationFilterUnitTest, TestHessianInvariants)
+{
+  /* Random hessian and its eigenvalues */
+  using EigenImageType = typename TestFixture::EigenImageType;
+  using FilterType = typename TestFixture::FilterType;
+  using HessianImageType = typename FilterType::HessianImageType;
+  auto hessian = HessianImageType::New();
+  hessian->SetRegions(this->m_Region);
+  hessian->Allocate();
+
+  unsigned int                                        seed = 1;
+  itk::ImageRegionIteratorWithIndex<HessianImageType> hessianIt(hessian, this->m_Region);
+  itk::ImageRegionIteratorWithIndex<EigenImageType>   input(this->m_MaskingEigenImage, this->m_Region);
+  for (; !hessianIt.IsAtEnd(); ++hessianIt, ++input)
+  {
+    typename HessianImageType::PixelType tensor;
+    for (unsigned int i = 0; i < tensor.Size(); ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      tensor[i] = static_cast<double>(seed >> 8) / 65536.0 - 128;
+    }
+    typename HessianImageType::PixelType::EigenValuesArrayType eigenValues;
+    tensor.ComputeEigenValues(eigenValues);
+    typename TestFixture::EigenValueArrayType pixel;
+    for (unsigned int i = 0; i < pixel.Length; ++i)
+    {
+      pixel[i] = static_cast<TypeParam>(eigenValues[i]);
+    }
+    hessianIt.Set(tensor);
+    input.Set(pixel);
+  }
+
+  /* The implementation parameters are not invariants of the hessian */
+  this->m_Filter->SetInput(this->m_MaskingEigenImage);
+  EXPECT_FALSE(this->m_Filter->CanEstimateFromHessianInvariants());
+  EXPECT_THROW(this->m_Filter->EstimateFromHessianInvariants(hessian, this->m_Region), itk::ExceptionObject);
+
+  /* The journal parameters are, up to the rounding of the eigenvalues */
+  this->m_Filter->SetParameterSetToJournalArticle();
+  EXPECT_TRUE(this->m_Filter->CanEstimateFromHessianInvariants());
+  EXPECT_THROW(this->m_Filter->EstimateFromHessianInvariants(nullptr, this->m_Region), itk::ExceptionObject);
+  EXPECT_NO_THROW(this->m_Filter->Update());
+  const typename TestFixture::ParameterArrayType expected = this->m_Filter->GetParameters();
+
+  EXPECT_NO_THROW(this->m_Filter->EstimateFromHessianInvariants(hessian, this->m_Region));
+  this->m_Parameters = this->m_Filter->GetParameters();
+  for (unsigned int i = 0; i < expected.GetSize(); ++i)
+  {
+    EXPECT_NEAR(expected[i], this->m_Parameters[i], 1e-3);
+  }
+}
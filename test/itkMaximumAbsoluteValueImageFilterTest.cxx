@@ -20,6 +20,84 @@
 #include "itkTestingMacros.h"
 #include "itkImageRegionIterator.h"
 #include "itkTestingMacros.h"
+#include <climits>
+
+namespace
+{
+/* Compare the filter to the functor on random images of pixels between
+ * lowest and highest, the second input being the opposite or a copy of the
+ * first on some pixels and the extremes on others */
+template <typename TPixel>
+int
+TestPixelType(TPixel lowest, TPixel highest)
+{
+  using ImageType = itk::Image<TPixel, 3>;
+  using FilterType = itk::MaximumAbsoluteValueImageFilter<ImageType>;
+
+  typename ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 5;
+  size[2] = 3;
+  typename ImageType::IndexType start;
+  start[0] = -3;
+  start[1] = 2;
+  start[2] = 0;
+  const typename ImageType::RegionType region(start, size);
+
+  typename ImageType::Pointer image1 = ImageType::New();
+  image1->SetRegions(region);
+  image1->Allocate();
+  typename ImageType::Pointer image2 = ImageType::New();
+  image2->SetRegions(region);
+  image2->Allocate();
+
+  itk::ImageRegionIterator<ImageType> it1(image1, region);
+  itk::ImageRegionIterator<ImageType> it2(image2, region);
+  unsigned int                        seed = 1;
+  for (unsigned int i = 0; !it1.IsAtEnd(); ++it1, ++it2, ++i)
+  {
+    seed = 1664525u * seed + 1013904223u;
+    const double fraction1 = static_cast<double>(seed >> 8) / 16777216.0;
+    seed = 1664525u * seed + 1013904223u;
+    const double fraction2 = static_cast<double>(seed >> 8) / 16777216.0;
+    const TPixel value1 = static_cast<TPixel>(lowest + fraction1 * (static_cast<double>(highest) - lowest));
+    TPixel       value2 = static_cast<TPixel>(lowest + fraction2 * (static_cast<double>(highest) - lowest));
+    switch (i % 5)
+    {
+      case 0:
+        value2 = static_cast<TPixel>(-value1);
+        break;
+      case 1:
+        value2 = value1;
+        break;
+      case 2:
+        value2 = i % 2 ? lowest : highest;
+        break;
+      default:
+        break;
+    }
+    it1.Set(value1);
+    it2.Set(value2);
+  }
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput1(image1);
+  filter->SetInput2(image2);
+  ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
+
+  itk::Functor::MaximumAbsoluteValue<TPixel> functor;
+  itk::ImageRegionIterator<ImageType>        ot(filter->GetOutput(), region);
+  for (it1.GoToBegin(), it2.GoToBegin(); !ot.IsAtEnd(); ++it1, ++it2, ++ot)
+  {
+    if (ot.Get() != functor(it1.Get(), it2.Get()))
+    {
+      std::cerr << "Maximum of " << +it1.Get() << " and " << +it2.Get() << " is " << +ot.Get() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+} // namespace
 
 int
 itkMaximumAbsoluteValueImageFilterTest(int, char *[])
@@ -97,5 +175,27 @@ itkMaximumAbsoluteValueImageFilterTest(int, char *[])
     }
     ++ot;
   }
+
+  /* A constant input is handled by the superclass */
+  maxAbsFilter->SetConstant2(-3);
+  ITK_TRY_EXPECT_NO_EXCEPTION(maxAbsFilter->Update());
+  for (ot.GoToBegin(); !ot.IsAtEnd(); ++ot)
+  {
+    ITK_TEST_EXPECT_EQUAL(ot.Get(), -3);
+  }
+
+  /* The vectorized pixel types, the absolute value of SHRT_MIN not being a short */
+  ITK_TEST_EXPECT_EQUAL(TestPixelType<float>(-5.0f, 5.0f), EXIT_SUCCESS);
+  ITK_TEST_EXPECT_EQUAL(TestPixelType<double>(-1e300, 1e300), EXIT_SUCCESS);
+  ITK_TEST_EXPECT_EQUAL(TestPixelType<short>(SHRT_MIN, SHRT_MAX), EXIT_SUCCESS);
+
+  short shortMinimum = SHRT_MIN;
+  short shortMaximum = SHRT_MAX;
+  short shortOutput = 0;
+  itk::Functor::MaximumAbsoluteValueSpan(&shortMinimum, &shortMaximum, &shortOutput, 1);
+  ITK_TEST_EXPECT_EQUAL(shortOutput, SHRT_MIN);
+  itk::Functor::MaximumAbsoluteValueSpan(&shortMaximum, &shortMinimum, &shortOutput, 1);
+  ITK_TEST_EXPECT_EQUAL(shortOutput, SHRT_MIN);
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,263 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiScaleHessianEnhancementImageFilter.h"
+#include "itkDescoteauxEigenToMeasureImageFilter.h"
+#include "itkDescoteauxEigenToMeasureParameterEstimationFilter.h"
+#include "itkEllipseSpatialObject.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+#include "itkMath.h"
+#include <algorithm>
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using MultiScaleFilterType = itk::MultiScaleHessianEnhancementImageFilter<ImageType, ImageType>;
+using EigenValueImageType = MultiScaleFilterType::EigenValueImageType;
+using MeasureFilterType = itk::DescoteauxEigenToMeasureImageFilter<EigenValueImageType, ImageType>;
+using EstimationFilterType = itk::DescoteauxEigenToMeasureParameterEstimationFilter<EigenValueImageType>;
+using EllipseType = itk::EllipseSpatialObject<Dimension>;
+
+/* Enhance the image with and without cropping to the mask */
+ImageType::Pointer
+Enhance(const ImageType *   image,
+        const EllipseType * mask,
+        bool                cropToMask,
+        bool                fusedEigenAnalysis,
+        bool                hessianInvariantEstimation = false,
+        bool                twoPassStreaming = false)
+{
+  MultiScaleFilterType::SigmaArrayType sigmaArray(2);
+  sigmaArray[0] = 1.0;
+  sigmaArray[1] = 2.0;
+
+  MultiScaleFilterType::Pointer filter = MultiScaleFilterType::New();
+  filter->SetInput(image);
+  filter->SetImageMask(mask);
+  filter->SetEigenToMeasureImageFilter(MeasureFilterType::New());
+  EstimationFilterType::Pointer estimationFilter = EstimationFilterType::New();
+  if (twoPassStreaming)
+  {
+    /* A few slices per piece */
+    estimationFilter->SetMemoryBudget(64 * 64 * 4 * 64);
+  }
+  filter->SetEigenToMeasureParameterEstimationFilter(estimationFilter);
+  filter->SetSigmaArray(sigmaArray);
+  filter->SetCropToMask(cropToMask);
+  filter->SetFusedEigenAnalysis(fusedEigenAnalysis);
+  filter->SetHessianInvariantEstimation(hessianInvariantEstimation);
+  filter->SetTwoPassStreaming(twoPassStreaming);
+  filter->Update();
+
+  ImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+/* Enhance the image at a single scale, with the parameters estimated at the given sigmas */
+ImageType::Pointer
+EnhanceAtScale(const ImageType * image, double sigma, const MultiScaleFilterType::SigmaArrayType & estimationSigmaArray)
+{
+  MultiScaleFilterType::SigmaArrayType sigmaArray(1);
+  sigmaArray[0] = sigma;
+
+  MultiScaleFilterType::Pointer filter = MultiScaleFilterType::New();
+  filter->SetInput(image);
+  filter->SetEigenToMeasureImageFilter(MeasureFilterType::New());
+  filter->SetEigenToMeasureParameterEstimationFilter(EstimationFilterType::New());
+  filter->SetSigmaArray(sigmaArray);
+  filter->SetEstimationSigmaArray(estimationSigmaArray);
+  filter->Update();
+
+  ImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+/* Largest difference between two responses */
+float
+MaximumDifference(const ImageType * first, const ImageType * second)
+{
+  float                                             difference = 0.0f;
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(first, first->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    difference = std::max(difference, itk::Math::abs(second->GetPixel(it.GetIndex()) - it.Get()));
+  }
+  return difference;
+}
+
+/* Compare every pixel of the cropped enhancement to the full one */
+int
+CompareCroppedToFull(const ImageType * image, const EllipseType * mask, bool fusedEigenAnalysis)
+{
+  ImageType::Pointer full;
+  ImageType::Pointer cropped;
+  ITK_TRY_EXPECT_NO_EXCEPTION(full = Enhance(image, mask, false, fusedEigenAnalysis));
+  ITK_TRY_EXPECT_NO_EXCEPTION(cropped = Enhance(image, mask, true, fusedEigenAnalysis));
+  ITK_TEST_EXPECT_TRUE(cropped->GetBufferedRegion() == image->GetLargestPossibleRegion());
+
+  itk::ImageRegionConstIteratorWithIndex<ImageType> fullIt(full, full->GetBufferedRegion());
+  for (; !fullIt.IsAtEnd(); ++fullIt)
+  {
+    const float expected = fullIt.Get();
+    const float computed = cropped->GetPixel(fullIt.GetIndex());
+    if (itk::Math::abs(computed - expected) > 1e-6f)
+    {
+      std::cerr << "Cropped response " << computed << " differs from " << expected << " at " << fullIt.GetIndex()
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+} // namespace
+
+int
+itkMultiScaleHessianEnhancementImageFilterCropTest(int, char *[])
+{
+  MultiScaleFilterType::Pointer filter = MultiScaleFilterType::New();
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, MultiScaleHessianEnhancementImageFilter, ImageToImageFilter);
+  ITK_TEST_SET_GET_BOOLEAN(filter, CropToMask, true);
+  ITK_TEST_SET_GET_BOOLEAN(filter, CropToMask, false);
+  ITK_TEST_SET_GET_BOOLEAN(filter, HessianInvariantEstimation, true);
+  ITK_TEST_SET_GET_BOOLEAN(filter, HessianInvariantEstimation, false);
+  ITK_TEST_SET_GET_BOOLEAN(filter, TwoPassStreaming, true);
+  ITK_TEST_SET_GET_BOOLEAN(filter, TwoPassStreaming, false);
+
+  /* Random image with an anisotropic spacing */
+  ImageType::SizeType size;
+  size[0] = 40;
+  size[1] = 36;
+  size[2] = 30;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 0.5;
+  spacing[2] = 0.75;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(size));
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  unsigned int                        seed = 1;
+  itk::ImageRegionIterator<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    seed = 1664525u * seed + 1013904223u;
+    it.Set(static_cast<float>(seed >> 16) / 65536.0f);
+  }
+
+  /* Mask away from the borders, so the kernels are not cropped by the image */
+  EllipseType::Pointer   ellipse = EllipseType::New();
+  EllipseType::PointType center;
+  EllipseType::ArrayType radius;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    center[i] = 0.4 * spacing[i] * size[i];
+    radius[i] = 0.2 * spacing[i] * size[i];
+  }
+  ellipse->SetCenterInObjectSpace(center);
+  ellipse->SetRadiusInObjectSpace(radius);
+  ellipse->Update();
+
+  if (CompareCroppedToFull(image, ellipse, false) == EXIT_FAILURE ||
+      CompareCroppedToFull(image, ellipse, true) == EXIT_FAILURE)
+  {
+    return EXIT_FAILURE;
+  }
+
+  /* The parameters estimated from the hessian, or in a first streamed pass, give the same response */
+  ImageType::Pointer fromEigenValues;
+  ImageType::Pointer fromHessian;
+  ImageType::Pointer twoPass;
+  ITK_TRY_EXPECT_NO_EXCEPTION(fromEigenValues = Enhance(image, ellipse, true, false));
+  ITK_TRY_EXPECT_NO_EXCEPTION(fromHessian = Enhance(image, ellipse, true, false, true));
+  ITK_TRY_EXPECT_NO_EXCEPTION(twoPass = Enhance(image, ellipse, true, false, false, true));
+  itk::ImageRegionConstIteratorWithIndex<ImageType> responseIt(fromEigenValues, image->GetLargestPossibleRegion());
+  for (; !responseIt.IsAtEnd(); ++responseIt)
+  {
+    const float computed = fromHessian->GetPixel(responseIt.GetIndex());
+    if (itk::Math::abs(computed - responseIt.Get()) > 1e-5f)
+    {
+      std::cerr << "Response " << computed << " from the hessian differs from " << responseIt.Get() << " at "
+                << responseIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+    const float streamed = twoPass->GetPixel(responseIt.GetIndex());
+    if (itk::Math::abs(streamed - responseIt.Get()) > 1e-6f)
+    {
+      std::cerr << "Response " << streamed << " of two passes differs from " << responseIt.Get() << " at "
+                << responseIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /* Parameters estimated at the scale itself, at a reference scale, or pooled over scales */
+  MultiScaleFilterType::SigmaArrayType estimationSigmaArray;
+  MultiScaleFilterType::Pointer        defaults = MultiScaleFilterType::New();
+  ITK_TEST_EXPECT_EQUAL(defaults->GetEstimationSigmaArray().GetSize(), 0u);
+  ImageType::Pointer everyScale;
+  ImageType::Pointer sameScale;
+  ImageType::Pointer referenceScale;
+  ImageType::Pointer pooledScales;
+  ITK_TRY_EXPECT_NO_EXCEPTION(everyScale = EnhanceAtScale(image, 2.0, estimationSigmaArray));
+  estimationSigmaArray.SetSize(1);
+  estimationSigmaArray[0] = 2.0;
+  ITK_TRY_EXPECT_NO_EXCEPTION(sameScale = EnhanceAtScale(image, 2.0, estimationSigmaArray));
+  estimationSigmaArray[0] = 1.0;
+  ITK_TRY_EXPECT_NO_EXCEPTION(referenceScale = EnhanceAtScale(image, 2.0, estimationSigmaArray));
+  estimationSigmaArray.SetSize(2);
+  estimationSigmaArray[0] = 2.0;
+  estimationSigmaArray[1] = 1.0;
+  ITK_TRY_EXPECT_NO_EXCEPTION(pooledScales = EnhanceAtScale(image, 2.0, estimationSigmaArray));
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(everyScale, sameScale) <= 1e-6f);
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(everyScale, referenceScale) > 1e-4f);
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(everyScale, pooledScales) > 1e-4f);
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(referenceScale, pooledScales) > 1e-4f);
+
+  /* Mask touching the border of the image */
+  center[0] = 0.0;
+  ellipse->SetCenterInObjectSpace(center);
+  ellipse->Update();
+  if (CompareCroppedToFull(image, ellipse, false) == EXIT_FAILURE)
+  {
+    return EXIT_FAILURE;
+  }
+
+  /* Mask outside of the image, the output is zero */
+  center.Fill(-100.0);
+  ellipse->SetCenterInObjectSpace(center);
+  ellipse->Update();
+  ImageType::Pointer empty;
+  ITK_TRY_EXPECT_NO_EXCEPTION(empty = Enhance(image, ellipse, true, false));
+  itk::ImageRegionConstIteratorWithIndex<ImageType> emptyIt(empty, image->GetLargestPossibleRegion());
+  for (; !emptyIt.IsAtEnd(); ++emptyIt)
+  {
+    if (emptyIt.Get() != 0.0f)
+    {
+      std::cerr << "Response " << emptyIt.Get() << " outside of the mask at " << emptyIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
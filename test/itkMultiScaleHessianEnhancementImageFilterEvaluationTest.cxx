@@ -0,0 +1,292 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiScaleHessianEnhancementImageFilter.h"
+#include "itkDescoteauxEigenToMeasureImageFilter.h"
+#include "itkDescoteauxEigenToMeasureParameterEstimationFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+#include "itkMath.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using MultiScaleFilterType = itk::MultiScaleHessianEnhancementImageFilter<ImageType, ImageType>;
+using EigenValueImageType = MultiScaleFilterType::EigenValueImageType;
+using MeasureFilterType = itk::DescoteauxEigenToMeasureImageFilter<EigenValueImageType, ImageType>;
+using EstimationFilterType = itk::DescoteauxEigenToMeasureParameterEstimationFilter<EigenValueImageType>;
+using CostModelType = MultiScaleFilterType::CostModelType;
+using BackendType = MultiScaleFilterType::ConvolutionBackendEnum;
+
+/* Enhance the image over two scales. The default path uses the discrete backend and estimates the parameters at
+ * every scale. */
+ImageType::Pointer
+Enhance(const ImageType * image,
+        BackendType       backend = BackendType::Discrete,
+        CostModelType *   costModel = nullptr,
+        bool              incrementalSmoothing = false,
+        bool              pyramidEvaluation = false,
+        bool              estimateOnce = false)
+{
+  MultiScaleFilterType::SigmaArrayType sigmaArray(2);
+  sigmaArray[0] = 1.0;
+  sigmaArray[1] = 2.0;
+
+  MultiScaleFilterType::Pointer filter = MultiScaleFilterType::New();
+  filter->SetInput(image);
+  filter->SetEigenToMeasureImageFilter(MeasureFilterType::New());
+  filter->SetEigenToMeasureParameterEstimationFilter(EstimationFilterType::New());
+  filter->SetSigmaArray(sigmaArray);
+  filter->SetNumberOfWorkUnits(1);
+  filter->SetConvolutionBackend(backend);
+  if (costModel)
+  {
+    filter->SetCostModel(costModel);
+    filter->AutomaticConvolutionBackendOn();
+  }
+  filter->SetIncrementalSmoothing(incrementalSmoothing);
+  filter->SetPyramidEvaluation(pyramidEvaluation);
+  if (estimateOnce)
+  {
+    MultiScaleFilterType::SigmaArrayType estimationSigmaArray(1);
+    estimationSigmaArray[0] = 1.0;
+    filter->SetEstimationSigmaArray(estimationSigmaArray);
+  }
+  filter->Update();
+
+  ImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+/* Cost model reading a calibration in which only the given backend is free */
+CostModelType::Pointer
+CreateCostModel(const std::string & fileName, BackendType freeBackend)
+{
+  {
+    std::ofstream file(fileName.c_str());
+    file << Dimension << " 1";
+    const BackendType backends[] = { BackendType::Discrete, BackendType::Recursive, BackendType::FFT };
+    for (const auto backend : backends)
+    {
+      file << (backend == freeBackend ? " 0 0" : " 1 1");
+    }
+    file << std::endl;
+  }
+
+  CostModelType::Pointer costModel = CostModelType::New();
+  costModel->SetCalibrationFileName(fileName);
+  return costModel;
+}
+
+/* Cost model reading a calibration without overheads, with the coefficients of the Discrete, Recursive and FFT
+ * backends */
+CostModelType::Pointer
+CreateCostModel(const std::string & fileName, const double (&coefficients)[3])
+{
+  {
+    std::ofstream file(fileName.c_str());
+    file << Dimension << " 1";
+    for (const double coefficient : coefficients)
+    {
+      file << " 0 " << coefficient;
+    }
+    file << std::endl;
+  }
+
+  CostModelType::Pointer costModel = CostModelType::New();
+  costModel->SetCalibrationFileName(fileName);
+  return costModel;
+}
+
+/* Largest difference between two responses */
+float
+MaximumDifference(const ImageType * first, const ImageType * second)
+{
+  float                                             difference = 0.0f;
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(first, first->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    difference = std::max(difference, itk::Math::abs(second->GetPixel(it.GetIndex()) - it.Get()));
+  }
+  return difference;
+}
+
+/* Mean difference between two responses */
+double
+MeanDifference(const ImageType * first, const ImageType * second)
+{
+  double                                            difference = 0.0;
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(first, first->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    difference += itk::Math::abs(second->GetPixel(it.GetIndex()) - it.Get());
+  }
+  return difference / first->GetBufferedRegion().GetNumberOfPixels();
+}
+} // namespace
+
+int
+itkMultiScaleHessianEnhancementImageFilterEvaluationTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv) << " calibrationFilePrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string calibrationFilePrefix = argv[1];
+
+  MultiScaleFilterType::Pointer filter = MultiScaleFilterType::New();
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, MultiScaleHessianEnhancementImageFilter, ImageToImageFilter);
+  ITK_TEST_SET_GET_BOOLEAN(filter, AutomaticConvolutionBackend, true);
+  ITK_TEST_SET_GET_BOOLEAN(filter, AutomaticConvolutionBackend, false);
+  ITK_TEST_SET_GET_BOOLEAN(filter, IncrementalSmoothing, true);
+  ITK_TEST_SET_GET_BOOLEAN(filter, IncrementalSmoothing, false);
+  ITK_TEST_SET_GET_BOOLEAN(filter, PyramidEvaluation, true);
+  ITK_TEST_SET_GET_BOOLEAN(filter, PyramidEvaluation, false);
+
+  /* Two bright plates of different thicknesses across the first dimension, with an anisotropic spacing. The
+   * profile is smooth so the backends agree up to the truncation of the discrete kernels. */
+  ImageType::SizeType size;
+  size[0] = 64;
+  size[1] = 24;
+  size[2] = 16;
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 0.5;
+  spacing[2] = 0.75;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(size));
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    const double x = spacing[0] * it.GetIndex()[0];
+    const double thin = (x - 9.0) / 2.0;
+    const double thick = (x - 21.0) / 4.0;
+    it.Set(static_cast<float>(std::exp(-0.5 * thin * thin) + std::exp(-0.5 * thick * thick)));
+  }
+
+  ImageType::Pointer defaultResponse;
+  ITK_TRY_EXPECT_NO_EXCEPTION(defaultResponse = Enhance(image));
+  const float maximumResponse = *std::max_element(defaultResponse->GetBufferPointer(),
+                                                  defaultResponse->GetBufferPointer() +
+                                                    defaultResponse->GetBufferedRegion().GetNumberOfPixels());
+  ITK_TEST_EXPECT_TRUE(maximumResponse > 0.5f);
+
+  /* The default path computes the eigenvalues of a scale once, the estimation reads them in place in one piece */
+  MultiScaleFilterType::SigmaArrayType sigmaArray(1);
+  sigmaArray[0] = 1.0;
+  EstimationFilterType::Pointer estimationFilter = EstimationFilterType::New();
+  filter->SetInput(image);
+  filter->SetEigenToMeasureImageFilter(MeasureFilterType::New());
+  filter->SetEigenToMeasureParameterEstimationFilter(estimationFilter);
+  filter->SetSigmaArray(sigmaArray);
+  ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
+  ITK_TEST_EXPECT_EQUAL(1u, estimationFilter->GetNumberOfPieces());
+
+  /* The automatic backend computes the same response as the backend it selects */
+  ImageType::Pointer fftResponse;
+  ImageType::Pointer automaticFFTResponse;
+  ImageType::Pointer automaticDiscreteResponse;
+  ITK_TRY_EXPECT_NO_EXCEPTION(fftResponse = Enhance(image, BackendType::FFT));
+  ITK_TRY_EXPECT_NO_EXCEPTION(
+    automaticFFTResponse =
+      Enhance(image, BackendType::Discrete, CreateCostModel(calibrationFilePrefix + "FFT.txt", BackendType::FFT)));
+  ITK_TRY_EXPECT_NO_EXCEPTION(
+    automaticDiscreteResponse =
+      Enhance(image, BackendType::FFT, CreateCostModel(calibrationFilePrefix + "Discrete.txt", BackendType::Discrete)));
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(fftResponse, automaticFFTResponse) <= 1e-6f);
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(defaultResponse, automaticDiscreteResponse) <= 1e-6f);
+
+  /* and one close to the default path */
+  const float fftDifference = MaximumDifference(defaultResponse, automaticFFTResponse);
+  std::cout << "Automatic backend: maximum difference " << fftDifference << ", mean difference "
+            << MeanDifference(defaultResponse, automaticFFTResponse) << std::endl;
+  ITK_TEST_EXPECT_TRUE(fftDifference <= 5e-2f * maximumResponse);
+
+  /* Incremental smoothing differs from the default path by the truncation of the composed kernels */
+  ImageType::Pointer incrementalResponse;
+  ITK_TRY_EXPECT_NO_EXCEPTION(incrementalResponse = Enhance(image, BackendType::Discrete, nullptr, true));
+  const float incrementalDifference = MaximumDifference(defaultResponse, incrementalResponse);
+  std::cout << "Incremental smoothing: maximum difference " << incrementalDifference << ", mean difference "
+            << MeanDifference(defaultResponse, incrementalResponse) << std::endl;
+  ITK_TEST_EXPECT_TRUE(incrementalDifference <= 5e-2f * maximumResponse);
+
+  /* The pyramid evaluates the second scale on a grid twice as coarse in-plane and interpolates the response back.
+   * Interpolation errors concentrate on the flanks of the plates, so the mean difference is held tighter than the
+   * maximum. The same holds when the parameters are estimated once, on the fine grid, and used on the coarse one. */
+  for (const bool estimateOnce : { false, true })
+  {
+    ImageType::Pointer referenceResponse = defaultResponse;
+    if (estimateOnce)
+    {
+      ITK_TRY_EXPECT_NO_EXCEPTION(
+        referenceResponse = Enhance(image, BackendType::Discrete, nullptr, false, false, true));
+    }
+    ImageType::Pointer pyramidResponse;
+    ITK_TRY_EXPECT_NO_EXCEPTION(
+      pyramidResponse = Enhance(image, BackendType::Discrete, nullptr, false, true, estimateOnce));
+    const float  pyramidDifference = MaximumDifference(referenceResponse, pyramidResponse);
+    const double pyramidMeanDifference = MeanDifference(referenceResponse, pyramidResponse);
+    std::cout << "Pyramid evaluation" << (estimateOnce ? " estimating once" : "") << ": maximum difference "
+              << pyramidDifference << ", mean difference " << pyramidMeanDifference << std::endl;
+    ITK_TEST_EXPECT_TRUE(pyramidDifference <= 0.25f * maximumResponse);
+    ITK_TEST_EXPECT_TRUE(pyramidMeanDifference <= 0.03 * maximumResponse);
+  }
+
+  /* With the automatic backend the pyramid is a candidate the cost model weighs against the input grid. When only
+   * the discrete kernels are cheap, the second scale is cheaper on the coarse grid, where the kernels are narrower.
+   * When the recursive filters are, smoothing before downsampling costs more than the whole scale on the input
+   * grid. */
+  const double discreteCoefficients[] = { 1e-9, 1.0, 1.0 };
+  const double recursiveCoefficients[] = { 1.0, 1e-9, 1.0 };
+  ImageType::Pointer discretePyramidResponse;
+  ImageType::Pointer automaticDiscretePyramidResponse;
+  ImageType::Pointer recursiveResponse;
+  ImageType::Pointer automaticRecursivePyramidResponse;
+  ITK_TRY_EXPECT_NO_EXCEPTION(discretePyramidResponse = Enhance(image, BackendType::Discrete, nullptr, false, true));
+  ITK_TRY_EXPECT_NO_EXCEPTION(
+    automaticDiscretePyramidResponse = Enhance(image,
+                                               BackendType::FFT,
+                                               CreateCostModel(calibrationFilePrefix + "DiscreteCoefficient.txt",
+                                                               discreteCoefficients),
+                                               false,
+                                               true));
+  ITK_TRY_EXPECT_NO_EXCEPTION(recursiveResponse = Enhance(image, BackendType::Recursive));
+  ITK_TRY_EXPECT_NO_EXCEPTION(
+    automaticRecursivePyramidResponse = Enhance(image,
+                                                BackendType::FFT,
+                                                CreateCostModel(calibrationFilePrefix + "RecursiveCoefficient.txt",
+                                                                recursiveCoefficients),
+                                                false,
+                                                true));
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(discretePyramidResponse, automaticDiscretePyramidResponse) <= 1e-6f);
+  ITK_TEST_EXPECT_TRUE(MaximumDifference(recursiveResponse, automaticRecursivePyramidResponse) <= 1e-6f);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkSymmetricEigenValuesImageFilter.h"
+#include "itkSymmetricSecondRankTensor.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTestingMacros.h"
+#include "itkMath.h"
+
+namespace
+{
+/* Compare the filter against SymmetricEigenAnalysis for every ordering */
+template <unsigned int VDimension>
+int
+CompareToIterativeSolver(const std::vector<itk::SymmetricSecondRankTensor<double, VDimension>> & specialTensors)
+{
+  using TensorType = itk::SymmetricSecondRankTensor<double, VDimension>;
+  using TensorImageType = itk::Image<TensorType, VDimension>;
+  using EigenValueImageType = itk::Image<itk::Vector<float, VDimension>, VDimension>;
+  using FilterType = itk::SymmetricEigenValuesImageFilter<TensorImageType, EigenValueImageType>;
+  using OrderType = typename FilterType::EigenValueOrderEnum;
+  using MatrixType = itk::Matrix<double, VDimension, VDimension>;
+  using ArrayType = itk::FixedArray<double, VDimension>;
+  using SolverType = itk::SymmetricEigenAnalysis<MatrixType, ArrayType, MatrixType>;
+
+  /* Random matrices after a few special cases, more than a batch per line */
+  typename TensorImageType::SizeType size;
+  size.Fill(9);
+  size[0] = 150;
+  typename TensorImageType::Pointer image = TensorImageType::New();
+  image->SetRegions(typename TensorImageType::RegionType(size));
+  image->Allocate();
+
+  unsigned int                              seed = 1;
+  unsigned int                              count = 0;
+  itk::ImageRegionIterator<TensorImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++count)
+  {
+    if (count < specialTensors.size())
+    {
+      it.Set(specialTensors[count]);
+      continue;
+    }
+
+    TensorType tensor;
+    for (unsigned int c = 0; c < TensorType::InternalDimension; ++c)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      tensor[c] = static_cast<double>(seed >> 8) / (1 << 23) - 1.0;
+    }
+    it.Set(tensor);
+  }
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+
+  const OrderType orders[] = { OrderType::OrderByValue, OrderType::OrderByMagnitude, OrderType::DoNotOrder };
+  for (const auto order : orders)
+  {
+    filter->SetEigenValueOrder(order);
+    ITK_TEST_EXPECT_TRUE(filter->GetEigenValueOrder() == order);
+    ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
+
+    SolverType solver(VDimension);
+    solver.SetOrderEigenValues(order != OrderType::OrderByMagnitude);
+    solver.SetOrderEigenMagnitudes(order == OrderType::OrderByMagnitude);
+
+    const typename TensorImageType::RegionType         region = image->GetLargestPossibleRegion();
+    itk::ImageRegionConstIterator<TensorImageType>     tensorIt(image, region);
+    itk::ImageRegionConstIterator<EigenValueImageType> eigenIt(filter->GetOutput(), region);
+    for (; !tensorIt.IsAtEnd(); ++tensorIt, ++eigenIt)
+    {
+      MatrixType matrix;
+      for (unsigned int i = 0; i < VDimension; ++i)
+      {
+        for (unsigned int j = 0; j < VDimension; ++j)
+        {
+          matrix(i, j) = tensorIt.Get()(i, j);
+        }
+      }
+      ArrayType expected;
+      solver.ComputeEigenValues(matrix, expected);
+
+      double scale = 1.0;
+      for (unsigned int i = 0; i < VDimension; ++i)
+      {
+        scale = std::max(scale, itk::Math::abs(expected[i]));
+      }
+      for (unsigned int i = 0; i < VDimension; ++i)
+      {
+        if (itk::Math::abs(eigenIt.Get()[i] - expected[i]) > 1e-6 * scale)
+        {
+          std::cerr << "Eigenvalues " << eigenIt.Get() << " of " << tensorIt.Get() << " differ from " << expected
+                    << " with order " << static_cast<int>(order) << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+} // namespace
+
+int
+itkSymmetricEigenValuesImageFilterTest(int, char *[])
+{
+  using Tensor2DType = itk::SymmetricSecondRankTensor<double, 2>;
+  using Tensor3DType = itk::SymmetricSecondRankTensor<double, 3>;
+  using FilterType =
+    itk::SymmetricEigenValuesImageFilter<itk::Image<Tensor3DType, 3>, itk::Image<itk::Vector<float, 3>, 3>>;
+
+  FilterType::Pointer filter = FilterType::New();
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, SymmetricEigenValuesImageFilter, ImageToImageFilter);
+  ITK_TEST_EXPECT_TRUE(filter->GetEigenValueOrder() == FilterType::EigenValueOrderEnum::OrderByValue);
+
+  /* Zero, isotropic, repeated and nearly repeated eigenvalues */
+  std::vector<Tensor3DType> special3D(6);
+  special3D[0].Fill(0.0);
+  special3D[1].SetIdentity();
+  special3D[1] *= 5.0;
+  special3D[2].Fill(0.0);
+  special3D[2](0, 0) = 1.0;
+  special3D[2](1, 1) = 1.0;
+  special3D[2](2, 2) = -2.0;
+  special3D[3] = special3D[2];
+  special3D[3](1, 1) = 1.0 + 1e-9;
+  special3D[4].Fill(1.0);
+  special3D[5] = special3D[1];
+  special3D[5](0, 1) = 1e-7;
+
+  std::vector<Tensor2DType> special2D(3);
+  special2D[0].Fill(0.0);
+  special2D[1].SetIdentity();
+  special2D[2].Fill(1.0);
+
+  if (CompareToIterativeSolver<3>(special3D) == EXIT_FAILURE || CompareToIterativeSolver<2>(special2D) == EXIT_FAILURE)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkVoxelMask.h"
+#include "itkEllipseSpatialObject.h"
+#include "itkDescoteauxEigenToMeasureImageFilter.h"
+#include "itkDescoteauxEigenToMeasureParameterEstimationFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+#include "itkMath.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+int
+itkVoxelMaskTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using VoxelMaskType = itk::VoxelMask<Dimension>;
+  using EllipseType = itk::EllipseSpatialObject<Dimension>;
+  using EigenValueImageType = itk::Image<itk::FixedArray<float, Dimension>, Dimension>;
+  using MeasureImageType = itk::Image<float, Dimension>;
+  using MeasureFilterType = itk::DescoteauxEigenToMeasureImageFilter<EigenValueImageType, MeasureImageType>;
+  using EstimationFilterType = itk::DescoteauxEigenToMeasureParameterEstimationFilter<EigenValueImageType>;
+
+  VoxelMaskType::Pointer voxelMask = VoxelMaskType::New();
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(voxelMask, VoxelMask, Object);
+
+  /* Random eigenvalues on a grid with an origin and an anisotropic spacing,
+   * scanlines longer than a word */
+  EigenValueImageType::SizeType size;
+  size[0] = 70;
+  size[1] = 13;
+  size[2] = 9;
+  EigenValueImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.0;
+  spacing[2] = 1.5;
+  EigenValueImageType::PointType origin;
+  origin[0] = -3.0;
+  origin[1] = 2.0;
+  origin[2] = 0.5;
+  EigenValueImageType::IndexType start;
+  start[0] = 4;
+  start[1] = -2;
+  start[2] = 1;
+
+  EigenValueImageType::Pointer image = EigenValueImageType::New();
+  image->SetRegions(EigenValueImageType::RegionType(start, size));
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->Allocate();
+
+  unsigned int                                  seed = 1;
+  itk::ImageRegionIterator<EigenValueImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    EigenValueImageType::PixelType pixel;
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      seed = 1664525u * seed + 1013904223u;
+      pixel[i] = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+    }
+    std::sort(pixel.Begin(), pixel.End(), [](float a, float b) { return std::abs(a) < std::abs(b); });
+    it.Set(pixel);
+  }
+
+  /* Ellipse covering part of the image */
+  EllipseType::Pointer   ellipse = EllipseType::New();
+  EllipseType::PointType center;
+  EllipseType::ArrayType radius;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    center[i] = origin[i] + spacing[i] * (start[i] + 0.5 * size[i]);
+    radius[i] = 0.3 * spacing[i] * size[i];
+  }
+  ellipse->SetCenterInObjectSpace(center);
+  ellipse->SetRadiusInObjectSpace(radius);
+  ellipse->Update();
+
+  ITK_TRY_EXPECT_EXCEPTION(voxelMask->Rasterize(nullptr, image));
+  ITK_TEST_EXPECT_TRUE(!voxelMask->IsOnGridOf(image));
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(voxelMask->Rasterize(ellipse, image));
+  ITK_TEST_EXPECT_TRUE(voxelMask->GetRegion() == image->GetLargestPossibleRegion());
+  ITK_TEST_EXPECT_TRUE(voxelMask->IsOnGridOf(image));
+  ITK_TEST_EXPECT_TRUE(voxelMask->IsRasterizationOf(ellipse, image));
+
+  /* Every pixel is where the spatial object puts it */
+  itk::SizeValueType                                          inside = 0;
+  EigenValueImageType::PointType                              point;
+  itk::ImageRegionConstIteratorWithIndex<EigenValueImageType> indexIt(image, image->GetLargestPossibleRegion());
+  for (; !indexIt.IsAtEnd(); ++indexIt)
+  {
+    image->TransformIndexToPhysicalPoint(indexIt.GetIndex(), point);
+    const bool expected = ellipse->IsInsideInObjectSpace(point);
+    if (voxelMask->IsInside(indexIt.GetIndex()) != expected)
+    {
+      std::cerr << "Pixel " << indexIt.GetIndex() << " should " << (expected ? "" : "not ") << "be inside"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    inside += expected;
+  }
+  ITK_TEST_EXPECT_EQUAL(inside, voxelMask->GetNumberOfPixelsInside());
+  ITK_TEST_EXPECT_TRUE(inside > 0 && inside < image->GetLargestPossibleRegion().GetNumberOfPixels());
+
+  EigenValueImageType::IndexType outside = start;
+  outside[1] -= 1;
+  ITK_TEST_EXPECT_TRUE(!voxelMask->IsInside(outside));
+
+  /* The runs of every scanline, whole and clipped, cover the pixels inside */
+  itk::SizeValueType numberOfRuns = 0;
+  for (indexIt.GoToBegin(); !indexIt.IsAtEnd(); ++indexIt)
+  {
+    const EigenValueImageType::IndexType lineIndex = indexIt.GetIndex();
+    if (lineIndex[0] != start[0])
+    {
+      continue;
+    }
+    for (itk::IndexValueType clip = 0; clip < 2; ++clip)
+    {
+      EigenValueImageType::IndexType visitIndex = lineIndex;
+      visitIndex[0] += 3 * clip;
+      const itk::SizeValueType length = size[0] - 5 * clip;
+      std::vector<bool>        covered(length, false);
+      itk::IndexValueType      previousEnd = visitIndex[0] - 1;
+      bool                     ordered = true;
+      voxelMask->VisitRuns(visitIndex, length, [&](itk::IndexValueType runStart, itk::SizeValueType runLength) {
+        ordered = ordered && runStart > previousEnd && runLength > 0;
+        previousEnd = runStart + static_cast<itk::IndexValueType>(runLength);
+        for (itk::SizeValueType i = 0; i < runLength; ++i)
+        {
+          covered[runStart - visitIndex[0] + i] = true;
+        }
+        numberOfRuns += 1 - clip;
+      });
+      ITK_TEST_EXPECT_TRUE(ordered && previousEnd <= visitIndex[0] + static_cast<itk::IndexValueType>(length));
+      for (itk::SizeValueType i = 0; i < length; ++i)
+      {
+        EigenValueImageType::IndexType index = visitIndex;
+        index[0] += static_cast<itk::IndexValueType>(i);
+        if (covered[i] != voxelMask->IsInside(index))
+        {
+          std::cerr << "Pixel " << index << " is " << (covered[i] ? "" : "not ") << "in a run" << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  ITK_TEST_EXPECT_EQUAL(numberOfRuns, voxelMask->GetNumberOfRuns());
+
+  /* The bounding region is the smallest one holding the pixels inside */
+  EigenValueImageType::IndexType lower = image->GetLargestPossibleRegion().GetUpperIndex();
+  EigenValueImageType::IndexType upper = start;
+  for (indexIt.GoToBegin(); !indexIt.IsAtEnd(); ++indexIt)
+  {
+    if (voxelMask->IsInside(indexIt.GetIndex()))
+    {
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        lower[i] = std::min(lower[i], indexIt.GetIndex()[i]);
+        upper[i] = std::max(upper[i], indexIt.GetIndex()[i]);
+      }
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(voxelMask->GetBoundingRegion().GetIndex() == lower);
+  ITK_TEST_EXPECT_TRUE(voxelMask->GetBoundingRegion().GetUpperIndex() == upper);
+  unsigned int runsOutside = 0;
+  voxelMask->VisitRuns(outside, size[0], [&runsOutside](itk::IndexValueType, itk::SizeValueType) { ++runsOutside; });
+  ITK_TEST_EXPECT_EQUAL(runsOutside, 0u);
+
+  /* Other grids */
+  EigenValueImageType::Pointer other = EigenValueImageType::New();
+  other->CopyInformation(image);
+  ITK_TEST_EXPECT_TRUE(voxelMask->IsOnGridOf(other));
+  EigenValueImageType::SizeType smallerSize = size;
+  smallerSize[0] = 10;
+  other->SetLargestPossibleRegion(EigenValueImageType::RegionType(start, smallerSize));
+  ITK_TEST_EXPECT_TRUE(voxelMask->IsOnGridOf(other));
+  ITK_TEST_EXPECT_TRUE(!voxelMask->IsRasterizationOf(ellipse, other));
+  other->CopyInformation(image);
+  other->SetSpacing(2.0 * spacing);
+  ITK_TEST_EXPECT_TRUE(!voxelMask->IsOnGridOf(other));
+
+  /* A modified spatial object must be rasterized again */
+  ellipse->Modified();
+  ITK_TEST_EXPECT_TRUE(!voxelMask->IsRasterizationOf(ellipse, image));
+
+  /* The filters give the same results with the rasterized mask */
+  EstimationFilterType::Pointer estimationFilter = EstimationFilterType::New();
+  estimationFilter->SetInput(image);
+  estimationFilter->SetMask(ellipse);
+  MeasureFilterType::Pointer measureFilter = MeasureFilterType::New();
+  measureFilter->SetInput(estimationFilter->GetOutput());
+  measureFilter->SetParametersInput(estimationFilter->GetParametersOutput());
+  measureFilter->SetMask(ellipse);
+  ITK_TRY_EXPECT_NO_EXCEPTION(measureFilter->Update());
+
+  const EstimationFilterType::ParameterArrayType expectedParameters = estimationFilter->GetParameters();
+  MeasureImageType::Pointer                      expectedMeasure = measureFilter->GetOutput();
+  expectedMeasure->DisconnectPipeline();
+
+  /* Rasterized by the multi-threader of a filter, as the filters owning a mask do */
+  ITK_TRY_EXPECT_NO_EXCEPTION(voxelMask->Rasterize(ellipse, image, estimationFilter->GetMultiThreader(), 2));
+  estimationFilter->SetVoxelMask(voxelMask);
+  ITK_TEST_SET_GET_VALUE(voxelMask.GetPointer(), estimationFilter->GetVoxelMask());
+  measureFilter->SetVoxelMask(voxelMask);
+  ITK_TEST_SET_GET_VALUE(voxelMask.GetPointer(), measureFilter->GetVoxelMask());
+  ITK_TRY_EXPECT_NO_EXCEPTION(measureFilter->Update());
+
+  /* The measure filter evaluates the pixels of the rasterized mask in batches and the others one by one,
+   * so the results may differ by a few units in the last place */
+  constexpr unsigned int maximumUlps = 4;
+  for (unsigned int i = 0; i < expectedParameters.GetSize(); ++i)
+  {
+    ITK_TEST_EXPECT_TRUE(
+      itk::Math::FloatAlmostEqual(expectedParameters[i], estimationFilter->GetParameters()[i], maximumUlps));
+  }
+
+  itk::ImageRegionConstIterator<MeasureImageType> expectedIt(expectedMeasure, expectedMeasure->GetBufferedRegion());
+  itk::ImageRegionConstIterator<MeasureImageType> measureIt(measureFilter->GetOutput(),
+                                                            expectedMeasure->GetBufferedRegion());
+  for (; !expectedIt.IsAtEnd(); ++expectedIt, ++measureIt)
+  {
+    if (!itk::Math::FloatAlmostEqual(expectedIt.Get(), measureIt.Get(), maximumUlps))
+    {
+      std::cerr << "Measure " << measureIt.Get() << " differs from " << expectedIt.Get() << " at "
+                << measureIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}